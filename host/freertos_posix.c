@@ -0,0 +1,567 @@
+// Simulação host do kernel FreeRTOS: tarefas como pthreads, semáforos e event
+// groups com mutex/condvar e heap contabilizado contra configTOTAL_HEAP_SIZE.
+// As tarefas criadas antes de vTaskStartScheduler só rodam depois dele.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include "pico/stdlib.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "event_groups.h"
+
+struct host_semaphore
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    UBaseType_t contagem;
+    UBaseType_t maximo;
+    bool estatico;  // Memória do chamador (versão Static): vSemaphoreDelete não libera
+};
+
+struct tskTaskControlBlock
+{
+    pthread_t thread;
+    TaskFunction_t funcao;
+    void *parametro;
+    char nome[configMAX_TASK_NAME_LEN];
+    UBaseType_t prioridade;
+    configSTACK_DEPTH_TYPE pilha;
+    StackType_t *pilha_reservada;
+    UBaseType_t numero;
+    struct tskTaskControlBlock *proxima;  // Lista de todas as tarefas, para uxTaskGetSystemState
+    struct host_semaphore notificacao;  // Valor de notificação usado como contador
+};
+
+static pthread_mutex_t escalonador_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t escalonador_cond = PTHREAD_COND_INITIALIZER;
+static bool escalonador_iniciado = false;
+static __thread TaskHandle_t tarefa_atual;
+static TaskHandle_t tarefas = NULL;  // Protegida por escalonador_lock
+static UBaseType_t total_tarefas = 0;
+
+static pthread_mutex_t critico_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread int critico_aninhamento;
+
+struct host_event_group
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    EventBits_t bits;
+};
+
+_Static_assert(sizeof(struct tskTaskControlBlock) <= sizeof(StaticTask_t), "StaticTask_t pequeno demais");
+_Static_assert(sizeof(struct host_semaphore) <= sizeof(StaticSemaphore_t), "StaticSemaphore_t pequeno demais");
+_Static_assert(sizeof(struct host_event_group) <= sizeof(StaticEventGroup_t), "StaticEventGroup_t pequeno demais");
+
+static void iniciar_semaforo(SemaphoreHandle_t sem, UBaseType_t maximo, UBaseType_t inicial);
+static void iniciar_condicao(pthread_mutex_t *lock, pthread_cond_t *cond);
+static void calcular_limite(struct timespec *limite, TickType_t ticks);
+
+// ===================== TEMPO =====================
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(time_us_64() * configTICK_RATE_HZ / 1000000u);
+}
+
+static uint64_t ticks_para_us(TickType_t ticks)
+{
+    return (uint64_t)ticks * 1000000u / configTICK_RATE_HZ;
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+    sleep_us(ticks_para_us(xTicksToDelay));
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *pxPreviousWakeTime, TickType_t xTimeIncrement)
+{
+    TickType_t alvo = *pxPreviousWakeTime + xTimeIncrement;
+    TickType_t agora = xTaskGetTickCount();
+    *pxPreviousWakeTime = alvo;
+    if ((int32_t)(alvo - agora) <= 0)
+        return pdFALSE;
+    sleep_us(ticks_para_us(alvo - agora));
+    return pdTRUE;
+}
+
+void vTaskYield(void)
+{
+    sched_yield();
+}
+
+// ===================== TAREFAS =====================
+static void *executar_tarefa(void *arg)
+{
+    TaskHandle_t tarefa = (TaskHandle_t)arg;
+    tarefa_atual = tarefa;
+
+    pthread_mutex_lock(&escalonador_lock);
+    while (!escalonador_iniciado)
+        pthread_cond_wait(&escalonador_cond, &escalonador_lock);
+    pthread_mutex_unlock(&escalonador_lock);
+
+    tarefa->funcao(tarefa->parametro);
+    return NULL;
+}
+
+// Preenche o TCB (pilha já reservada) e cria a thread da tarefa
+static bool iniciar_tarefa(TaskHandle_t tarefa, TaskFunction_t funcao, const char *nome,
+                           configSTACK_DEPTH_TYPE pilha, void *parametro, UBaseType_t prioridade)
+{
+    iniciar_semaforo(&tarefa->notificacao, UINT32_MAX, 0);
+    tarefa->funcao = funcao;
+    tarefa->parametro = parametro;
+    tarefa->prioridade = prioridade;
+    tarefa->pilha = pilha;
+    snprintf(tarefa->nome, sizeof(tarefa->nome), "%s", nome ? nome : "");
+
+    if (pthread_create(&tarefa->thread, NULL, executar_tarefa, tarefa) != 0)
+        return false;
+    pthread_mutex_lock(&escalonador_lock);
+    tarefa->numero = ++total_tarefas;
+    tarefa->proxima = tarefas;
+    tarefas = tarefa;
+    pthread_mutex_unlock(&escalonador_lock);
+    // Nome visível no perf/top (limite de 15 caracteres do Linux)
+    char nome_thread[16];
+    snprintf(nome_thread, sizeof(nome_thread), "%s", tarefa->nome);
+    pthread_setname_np(tarefa->thread, nome_thread);
+    return true;
+}
+
+#if configSUPPORT_DYNAMIC_ALLOCATION
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char *pcName, configSTACK_DEPTH_TYPE usStackDepth,
+                       void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pxCreatedTask)
+{
+    // TCB e pilha saem do heap do FreeRTOS como no port real; a thread usa a própria pilha
+    TaskHandle_t tarefa = pvPortMalloc(sizeof(*tarefa));
+    if (!tarefa)
+        return pdFAIL;
+    memset(tarefa, 0, sizeof(*tarefa));
+    tarefa->pilha_reservada = pvPortMalloc((size_t)usStackDepth * sizeof(StackType_t));
+    if (!tarefa->pilha_reservada ||
+        !iniciar_tarefa(tarefa, pxTaskCode, pcName, usStackDepth, pvParameters, uxPriority))
+    {
+        vPortFree(tarefa->pilha_reservada);
+        vPortFree(tarefa);
+        return pdFAIL;
+    }
+    if (pxCreatedTask)
+        *pxCreatedTask = tarefa;
+    return pdPASS;
+}
+#endif
+
+#if configSUPPORT_STATIC_ALLOCATION
+TaskHandle_t xTaskCreateStatic(TaskFunction_t pxTaskCode, const char *pcName, configSTACK_DEPTH_TYPE uxStackDepth,
+                               void *pvParameters, UBaseType_t uxPriority, StackType_t *puxStackBuffer,
+                               StaticTask_t *pxTaskBuffer)
+{
+    if (!puxStackBuffer || !pxTaskBuffer)
+        return NULL;
+    TaskHandle_t tarefa = (TaskHandle_t)pxTaskBuffer;
+    memset(tarefa, 0, sizeof(*tarefa));
+    tarefa->pilha_reservada = puxStackBuffer;
+    return iniciar_tarefa(tarefa, pxTaskCode, pcName, uxStackDepth, pvParameters, uxPriority) ? tarefa : NULL;
+}
+#endif
+
+void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+    if (xTaskToDelete == NULL || xTaskToDelete == tarefa_atual)
+        pthread_exit(NULL);
+    pthread_cancel(xTaskToDelete->thread);
+}
+
+void vTaskStartScheduler(void)
+{
+    pthread_mutex_lock(&escalonador_lock);
+    escalonador_iniciado = true;
+    pthread_cond_broadcast(&escalonador_cond);
+    pthread_mutex_unlock(&escalonador_lock);
+
+    // O "escalonador" nunca retorna: as tarefas seguem nas suas threads
+    while (1)
+        sleep_ms(1000);
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    pthread_mutex_lock(&escalonador_lock);
+    bool iniciado = escalonador_iniciado;
+    pthread_mutex_unlock(&escalonador_lock);
+    return iniciado ? taskSCHEDULER_RUNNING : taskSCHEDULER_NOT_STARTED;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return tarefa_atual;
+}
+
+char *pcTaskGetName(TaskHandle_t xTaskToQuery)
+{
+    TaskHandle_t tarefa = xTaskToQuery ? xTaskToQuery : tarefa_atual;
+    return tarefa ? tarefa->nome : NULL;
+}
+
+// Sem acesso à pilha real da pthread: reporta a pilha pedida como livre
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask)
+{
+    TaskHandle_t tarefa = xTask ? xTask : tarefa_atual;
+    return tarefa ? (UBaseType_t)tarefa->pilha : 0;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    pthread_mutex_lock(&escalonador_lock);
+    UBaseType_t total = total_tarefas;
+    pthread_mutex_unlock(&escalonador_lock);
+    return total;
+}
+
+// Tempo de CPU de cada tarefa é o da sua thread (CLOCK_THREAD_CPUTIME_ID) e o total é
+// o tempo desde o boot, como o contador de µs do port real. Sem escalonador próprio,
+// toda tarefa que não é a chamadora aparece bloqueada.
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *const pxTaskStatusArray, const UBaseType_t uxArraySize,
+                                 configRUN_TIME_COUNTER_TYPE *const pulTotalRunTime)
+{
+    UBaseType_t n = 0;
+    pthread_mutex_lock(&escalonador_lock);
+    if (uxArraySize >= total_tarefas)
+    {
+        for (TaskHandle_t t = tarefas; t; t = t->proxima, n++)
+        {
+            TaskStatus_t *st = &pxTaskStatusArray[n];
+            clockid_t relogio;
+            struct timespec cpu = {0};
+            if (pthread_getcpuclockid(t->thread, &relogio) == 0)
+                clock_gettime(relogio, &cpu);
+            st->xHandle = t;
+            st->pcTaskName = t->nome;
+            st->xTaskNumber = t->numero;
+            st->eCurrentState = t == tarefa_atual ? eRunning : eBlocked;
+            st->uxCurrentPriority = st->uxBasePriority = t->prioridade;
+            st->ulRunTimeCounter = (configRUN_TIME_COUNTER_TYPE)((uint64_t)cpu.tv_sec * 1000000u + cpu.tv_nsec / 1000);
+            st->pxStackBase = t->pilha_reservada;
+            st->usStackHighWaterMark = t->pilha;
+        }
+    }
+    pthread_mutex_unlock(&escalonador_lock);
+    if (pulTotalRunTime)
+        *pulTotalRunTime = (configRUN_TIME_COUNTER_TYPE)time_us_64();
+    return n;
+}
+
+// ===================== SEÇÃO CRÍTICA =====================
+void vPortEnterCritical(void)
+{
+    if (critico_aninhamento++ == 0)
+        pthread_mutex_lock(&critico_lock);
+}
+
+void vPortExitCritical(void)
+{
+    if (--critico_aninhamento == 0)
+        pthread_mutex_unlock(&critico_lock);
+}
+
+// ===================== SEMÁFOROS =====================
+static void iniciar_semaforo(SemaphoreHandle_t sem, UBaseType_t maximo, UBaseType_t inicial)
+{
+    memset(sem, 0, sizeof(*sem));
+    iniciar_condicao(&sem->lock, &sem->cond);
+    sem->maximo = maximo;
+    sem->contagem = inicial;
+}
+
+#if configSUPPORT_DYNAMIC_ALLOCATION
+static SemaphoreHandle_t criar_semaforo(UBaseType_t maximo, UBaseType_t inicial)
+{
+    SemaphoreHandle_t sem = pvPortMalloc(sizeof(*sem));
+    if (sem)
+        iniciar_semaforo(sem, maximo, inicial);
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return criar_semaforo(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return criar_semaforo(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount)
+{
+    return criar_semaforo(uxMaxCount, uxInitialCount);
+}
+#endif
+
+#if configSUPPORT_STATIC_ALLOCATION
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *pxMutexBuffer)
+{
+    SemaphoreHandle_t sem = (SemaphoreHandle_t)pxMutexBuffer;
+    iniciar_semaforo(sem, 1, 1);
+    sem->estatico = true;
+    return sem;
+}
+#endif
+
+// Mutex e condvar no relógio monotônico, o mesmo de time_us_64
+static void iniciar_condicao(pthread_mutex_t *lock, pthread_cond_t *cond)
+{
+    pthread_mutex_init(lock, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void calcular_limite(struct timespec *limite, TickType_t ticks)
+{
+    clock_gettime(CLOCK_MONOTONIC, limite);
+    uint64_t ns = (uint64_t)limite->tv_nsec + ticks_para_us(ticks) * 1000u;
+    limite->tv_sec += (time_t)(ns / 1000000000u);
+    limite->tv_nsec = (long)(ns % 1000000000u);
+}
+
+// Espera a contagem ficar positiva (ou o tempo esgotar) com o lock do semáforo tomado
+static void esperar_contagem(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    struct timespec limite;
+    calcular_limite(&limite, ticks);
+
+    while (sem->contagem == 0)
+    {
+        if (ticks == 0)
+            break;
+        int rc = ticks == portMAX_DELAY
+                     ? pthread_cond_wait(&sem->cond, &sem->lock)
+                     : pthread_cond_timedwait(&sem->cond, &sem->lock, &limite);
+        if (rc == ETIMEDOUT)
+            break;
+    }
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime)
+{
+    pthread_mutex_lock(&xSemaphore->lock);
+    esperar_contagem(xSemaphore, xBlockTime);
+    BaseType_t obtido = pdFALSE;
+    if (xSemaphore->contagem > 0)
+    {
+        xSemaphore->contagem--;
+        obtido = pdTRUE;
+    }
+    pthread_mutex_unlock(&xSemaphore->lock);
+    return obtido;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore)
+{
+    BaseType_t ok = pdFALSE;
+    pthread_mutex_lock(&xSemaphore->lock);
+    if (xSemaphore->contagem < xSemaphore->maximo)
+    {
+        xSemaphore->contagem++;
+        pthread_cond_signal(&xSemaphore->cond);
+        ok = pdTRUE;
+    }
+    pthread_mutex_unlock(&xSemaphore->lock);
+    return ok;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t xSemaphore, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    if (pxHigherPriorityTaskWoken)
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    return xSemaphoreGive(xSemaphore);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t xSemaphore)
+{
+    if (!xSemaphore)
+        return;
+    pthread_cond_destroy(&xSemaphore->cond);
+    pthread_mutex_destroy(&xSemaphore->lock);
+    if (!xSemaphore->estatico)
+        vPortFree(xSemaphore);
+}
+
+// ===================== NOTIFICAÇÕES =====================
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    SemaphoreHandle_t sem = &tarefa_atual->notificacao;
+    pthread_mutex_lock(&sem->lock);
+    esperar_contagem(sem, xTicksToWait);
+    uint32_t valor = (uint32_t)sem->contagem;
+    if (valor > 0)
+        sem->contagem = xClearCountOnExit ? 0 : valor - 1;
+    pthread_mutex_unlock(&sem->lock);
+    return valor;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    SemaphoreHandle_t sem = &xTaskToNotify->notificacao;
+    pthread_mutex_lock(&sem->lock);
+    sem->contagem++;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    if (pxHigherPriorityTaskWoken)
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    xTaskNotifyGive(xTaskToNotify);
+}
+
+// ===================== EVENT GROUPS =====================
+#if configSUPPORT_DYNAMIC_ALLOCATION
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    EventGroupHandle_t grupo = pvPortMalloc(sizeof(*grupo));
+    if (!grupo)
+        return NULL;
+    iniciar_condicao(&grupo->lock, &grupo->cond);
+    grupo->bits = 0;
+    return grupo;
+}
+#endif
+
+#if configSUPPORT_STATIC_ALLOCATION
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *pxEventGroupBuffer)
+{
+    EventGroupHandle_t grupo = (EventGroupHandle_t)pxEventGroupBuffer;
+    iniciar_condicao(&grupo->lock, &grupo->cond);
+    grupo->bits = 0;
+    return grupo;
+}
+#endif
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet)
+{
+    pthread_mutex_lock(&xEventGroup->lock);
+    xEventGroup->bits |= uxBitsToSet & 0x00ffffffu;
+    EventBits_t bits = xEventGroup->bits;
+    pthread_cond_broadcast(&xEventGroup->cond);
+    pthread_mutex_unlock(&xEventGroup->lock);
+    return bits;
+}
+
+BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet,
+                                     BaseType_t *pxHigherPriorityTaskWoken)
+{
+    if (pxHigherPriorityTaskWoken)
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    xEventGroupSetBits(xEventGroup, uxBitsToSet);
+    return pdPASS;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToClear)
+{
+    pthread_mutex_lock(&xEventGroup->lock);
+    EventBits_t bits = xEventGroup->bits;
+    xEventGroup->bits &= ~uxBitsToClear;
+    pthread_mutex_unlock(&xEventGroup->lock);
+    return bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToWaitFor,
+                                const BaseType_t xClearOnExit, const BaseType_t xWaitForAllBits,
+                                TickType_t xTicksToWait)
+{
+    struct timespec limite;
+    calcular_limite(&limite, xTicksToWait);
+
+    pthread_mutex_lock(&xEventGroup->lock);
+    while (1)
+    {
+        EventBits_t presentes = xEventGroup->bits & uxBitsToWaitFor;
+        bool satisfeito = xWaitForAllBits ? presentes == uxBitsToWaitFor : presentes != 0;
+        if (satisfeito || xTicksToWait == 0)
+            break;
+        int rc = xTicksToWait == portMAX_DELAY
+                     ? pthread_cond_wait(&xEventGroup->cond, &xEventGroup->lock)
+                     : pthread_cond_timedwait(&xEventGroup->cond, &xEventGroup->lock, &limite);
+        if (rc == ETIMEDOUT)
+            break;
+    }
+    // Como no kernel: o retorno é o valor antes da limpeza, e só limpa se satisfeito
+    EventBits_t bits = xEventGroup->bits;
+    EventBits_t presentes = bits & uxBitsToWaitFor;
+    if (xClearOnExit && (xWaitForAllBits ? presentes == uxBitsToWaitFor : presentes != 0))
+        xEventGroup->bits &= ~uxBitsToWaitFor;
+    pthread_mutex_unlock(&xEventGroup->lock);
+    return bits;
+}
+
+// ===================== HEAP =====================
+static pthread_mutex_t heap_lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t heap_usado = 0;
+static size_t heap_pico = 0;
+
+typedef union
+{
+    size_t tamanho;
+    max_align_t alinhamento;
+} cabecalho_heap_t;
+
+void *pvPortMalloc(size_t xSize)
+{
+    pthread_mutex_lock(&heap_lock);
+    bool cabe = heap_usado + xSize + sizeof(cabecalho_heap_t) <= configTOTAL_HEAP_SIZE;
+    pthread_mutex_unlock(&heap_lock);
+    if (!cabe)
+        return NULL;
+
+    cabecalho_heap_t *bloco = malloc(sizeof(cabecalho_heap_t) + xSize);
+    if (!bloco)
+        return NULL;
+    bloco->tamanho = xSize + sizeof(cabecalho_heap_t);
+
+    pthread_mutex_lock(&heap_lock);
+    heap_usado += bloco->tamanho;
+    if (heap_usado > heap_pico)
+        heap_pico = heap_usado;
+    pthread_mutex_unlock(&heap_lock);
+    return bloco + 1;
+}
+
+void vPortFree(void *pv)
+{
+    if (!pv)
+        return;
+    cabecalho_heap_t *bloco = (cabecalho_heap_t *)pv - 1;
+    pthread_mutex_lock(&heap_lock);
+    heap_usado -= bloco->tamanho;
+    pthread_mutex_unlock(&heap_lock);
+    free(bloco);
+}
+
+size_t xPortGetFreeHeapSize(void)
+{
+    pthread_mutex_lock(&heap_lock);
+    size_t livre = configTOTAL_HEAP_SIZE - heap_usado;
+    pthread_mutex_unlock(&heap_lock);
+    return livre;
+}
+
+size_t xPortGetMinimumEverFreeHeapSize(void)
+{
+    pthread_mutex_lock(&heap_lock);
+    size_t minimo = configTOTAL_HEAP_SIZE - heap_pico;
+    pthread_mutex_unlock(&heap_lock);
+    return minimo;
+}
@@ -0,0 +1,71 @@
+// Porta host de lib/i2c_dma.c: uma thread por barramento faz o papel do DMA e da
+// interrupção. Ela converte as palavras IC_DATA_CMD de volta em bytes, executa a
+// transação no barramento simulado (que dorme o tempo de fio; a parte escrita e a
+// lida viram uma escrita sem STOP seguida de uma leitura) e chama
+// i2c_dma_concluir, de modo que a tarefa que enfileirou segue livre enquanto isso.
+
+#include <stdio.h>
+#include <pthread.h>
+#include "i2c_dma.h"
+
+static struct
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    i2c_dma_t *bus;
+    bool pendente;
+    i2c_dma_transacao_t transacao;
+} portas[2] = {
+    {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER},
+    {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER},
+};
+
+static void *executar_porta(void *arg)
+{
+    uint indice = (uint)(uintptr_t)arg;
+    uint8_t bytes[2048];
+
+    while (1)
+    {
+        pthread_mutex_lock(&portas[indice].lock);
+        while (!portas[indice].pendente)
+            pthread_cond_wait(&portas[indice].cond, &portas[indice].lock);
+        portas[indice].pendente = false;
+        i2c_dma_t *bus = portas[indice].bus;
+        i2c_dma_transacao_t t = portas[indice].transacao;
+        pthread_mutex_unlock(&portas[indice].lock);
+
+        const uint16_t *palavras = &bus->palavras[t.inicio];
+        uint16_t n_escrita = t.n - t.n_leitura;
+        bool erro = n_escrita > sizeof(bytes);
+        if (!erro && n_escrita)
+        {
+            for (uint16_t i = 0; i < n_escrita; i++)
+                bytes[i] = (uint8_t)palavras[i];
+            erro = i2c_write_blocking(bus->i2c, t.endereco, bytes, n_escrita, t.n_leitura > 0) != (int)n_escrita;
+        }
+        if (!erro && t.n_leitura)
+            erro = i2c_read_blocking(bus->i2c, t.endereco, t.leitura, t.n_leitura, false) != (int)t.n_leitura;
+        i2c_dma_concluir(bus, erro);
+    }
+    return NULL;
+}
+
+void i2c_dma_porta_iniciar(i2c_dma_t *bus)
+{
+    uint indice = i2c_hw_index(bus->i2c);
+    portas[indice].bus = bus;
+    if (pthread_create(&portas[indice].thread, NULL, executar_porta, (void *)(uintptr_t)indice) != 0)
+        printf("[ERRO] i2c_dma: falha ao criar a thread do barramento %u\n", indice);
+}
+
+void i2c_dma_porta_transferir(i2c_dma_t *bus, const i2c_dma_transacao_t *t)
+{
+    uint indice = i2c_hw_index(bus->i2c);
+    pthread_mutex_lock(&portas[indice].lock);
+    portas[indice].transacao = *t;
+    portas[indice].pendente = true;
+    pthread_cond_signal(&portas[indice].cond);
+    pthread_mutex_unlock(&portas[indice].lock);
+}
@@ -0,0 +1,246 @@
+// Simulação host dos barramentos I2C da BitDogLab.
+// i2c0: AHT20 (0x38) e BMP280 (0x77); i2c1: display SSD1306 (0x3C).
+// Cada transação bloqueia pelo tempo que levaria no fio (9 bits por byte).
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+
+#define AHT20_ADDR 0x38
+#define BMP280_ADDR 0x77
+#define SSD1306_ADDR 0x3C
+
+#define AHT20_TEMPO_CONVERSAO_US 80000u
+
+struct i2c_inst
+{
+    uint baudrate;
+    pthread_mutex_t lock;
+};
+
+i2c_inst_t i2c0_inst = {.baudrate = 100000, .lock = PTHREAD_MUTEX_INITIALIZER};
+i2c_inst_t i2c1_inst = {.baudrate = 100000, .lock = PTHREAD_MUTEX_INITIALIZER};
+
+// ===================== MODELO DO AMBIENTE =====================
+static double segundos(void)
+{
+    return (double)time_us_64() / 1e6;
+}
+
+// ===================== AHT20 =====================
+static struct
+{
+    bool calibrado;
+    bool medindo;
+    uint64_t inicio_us;
+} aht20 = {.calibrado = true};
+
+static void aht20_escrever(const uint8_t *src, size_t len)
+{
+    if (len == 0)
+        return;
+    if (src[0] == 0xAC)
+    {
+        aht20.medindo = true;
+        aht20.inicio_us = time_us_64();
+    }
+    else if (src[0] == 0xBE)
+    {
+        aht20.calibrado = true;
+    }
+    else if (src[0] == 0xBA)
+    {
+        aht20.medindo = false;
+    }
+}
+
+static void aht20_ler(uint8_t *dst, size_t len)
+{
+    if (aht20.medindo && time_us_64() - aht20.inicio_us >= AHT20_TEMPO_CONVERSAO_US)
+        aht20.medindo = false;
+
+    uint8_t resposta[7];
+    resposta[0] = (aht20.medindo ? 0x80 : 0x00) | (aht20.calibrado ? 0x08 : 0x00) | 0x10;
+
+    double t = segundos();
+    double temperatura = 24.5 + 1.5 * sin(t / 600.0);
+    double umidade = 55.0 + 8.0 * sin(t / 900.0);
+    uint32_t raw_hum = (uint32_t)(umidade / 100.0 * 1048576.0);
+    uint32_t raw_temp = (uint32_t)((temperatura + 50.0) / 200.0 * 1048576.0);
+    resposta[1] = (uint8_t)(raw_hum >> 12);
+    resposta[2] = (uint8_t)(raw_hum >> 4);
+    resposta[3] = (uint8_t)(((raw_hum & 0x0F) << 4) | ((raw_temp >> 16) & 0x0F));
+    resposta[4] = (uint8_t)(raw_temp >> 8);
+    resposta[5] = (uint8_t)raw_temp;
+    resposta[6] = 0;
+
+    for (size_t i = 0; i < len; i++)
+        dst[i] = i < sizeof(resposta) ? resposta[i] : 0xFF;
+}
+
+// ===================== BMP280 =====================
+// Calibração e leituras brutas do exemplo do datasheet Bosch (25,08 °C / 1006,53 hPa)
+static const int32_t bmp280_calib[12] = {27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000};
+
+static struct
+{
+    uint8_t regs[256];
+    uint8_t ponteiro;
+    bool iniciado;
+    uint64_t fim_conversao_us;
+} bmp280;
+
+static void bmp280_resetar(void)
+{
+    memset(bmp280.regs, 0, sizeof(bmp280.regs));
+    for (int i = 0; i < 12; i++)
+    {
+        bmp280.regs[0x88 + 2 * i] = (uint8_t)(bmp280_calib[i] & 0xFF);
+        bmp280.regs[0x89 + 2 * i] = (uint8_t)((bmp280_calib[i] >> 8) & 0xFF);
+    }
+    bmp280.regs[0xD0] = 0x58;
+    bmp280.regs[0xF7] = 0x80;
+    bmp280.regs[0xFA] = 0x80;
+    bmp280.fim_conversao_us = 0;
+    bmp280.iniciado = true;
+}
+
+static void bmp280_amostrar(void)
+{
+    double t = segundos();
+    int32_t raw_temp = 519888 + (int32_t)(400.0 * sin(t / 600.0));
+    int32_t raw_press = 415148 + (int32_t)(300.0 * sin(t / 300.0));
+    bmp280.regs[0xF7] = (uint8_t)(raw_press >> 12);
+    bmp280.regs[0xF8] = (uint8_t)(raw_press >> 4);
+    bmp280.regs[0xF9] = (uint8_t)((raw_press & 0x0F) << 4);
+    bmp280.regs[0xFA] = (uint8_t)(raw_temp >> 12);
+    bmp280.regs[0xFB] = (uint8_t)(raw_temp >> 4);
+    bmp280.regs[0xFC] = (uint8_t)((raw_temp & 0x0F) << 4);
+}
+
+// Tempo máximo de medição do datasheet (seção 3.8.1), em microssegundos
+static uint64_t bmp280_tempo_medicao_us(uint8_t ctrl_meas)
+{
+    static const uint8_t fator[8] = {0, 1, 2, 4, 8, 16, 16, 16};
+    uint8_t osrs_t = fator[(ctrl_meas >> 5) & 0x07];
+    uint8_t osrs_p = fator[(ctrl_meas >> 2) & 0x07];
+    return 1250u + 2300u * osrs_t + (osrs_p ? 2300u * osrs_p + 575u : 0u);
+}
+
+// Atualiza o estado de conversão antes de qualquer acesso ao mapa de registradores
+static void bmp280_atualizar(void)
+{
+    uint8_t modo = bmp280.regs[0xF4] & 0x03;
+    uint64_t agora = time_us_64();
+    if (bmp280.fim_conversao_us && agora >= bmp280.fim_conversao_us)
+    {
+        bmp280_amostrar();
+        bmp280.fim_conversao_us = 0;
+        bmp280.regs[0xF3] &= ~0x08;
+        if (modo == 0x01 || modo == 0x02)
+            bmp280.regs[0xF4] &= ~0x03;
+    }
+    if (modo == 0x03 && bmp280.fim_conversao_us == 0)
+        bmp280_amostrar();
+}
+
+static void bmp280_escrever(const uint8_t *src, size_t len)
+{
+    if (!bmp280.iniciado)
+        bmp280_resetar();
+    bmp280_atualizar();
+    if (len == 1)
+    {
+        bmp280.ponteiro = src[0];
+        return;
+    }
+    // Escritas no BMP280 são pares registrador/valor
+    for (size_t i = 0; i + 1 < len; i += 2)
+    {
+        uint8_t reg = src[i], valor = src[i + 1];
+        if (reg == 0xE0)
+        {
+            if (valor == 0xB6)
+                bmp280_resetar();
+            continue;
+        }
+        bmp280.regs[reg] = valor;
+        if (reg == 0xF4 && ((valor & 0x03) == 0x01 || (valor & 0x03) == 0x02))
+        {
+            bmp280.fim_conversao_us = time_us_64() + bmp280_tempo_medicao_us(valor);
+            bmp280.regs[0xF3] |= 0x08;
+        }
+    }
+}
+
+static void bmp280_ler(uint8_t *dst, size_t len)
+{
+    if (!bmp280.iniciado)
+        bmp280_resetar();
+    bmp280_atualizar();
+    for (size_t i = 0; i < len; i++)
+        dst[i] = bmp280.regs[(uint8_t)(bmp280.ponteiro + i)];
+}
+
+// ===================== BARRAMENTO =====================
+static bool dispositivo_presente(i2c_inst_t *i2c, uint8_t addr)
+{
+    if (i2c == i2c0)
+        return addr == AHT20_ADDR || addr == BMP280_ADDR;
+    return addr == SSD1306_ADDR;
+}
+
+// Endereço + dados, 9 bits por byte, mais START/STOP
+static void esperar_fio(i2c_inst_t *i2c, size_t len)
+{
+    uint64_t bits = (uint64_t)(len + 1) * 9u + 2u;
+    sleep_us(bits * 1000000u / (i2c->baudrate ? i2c->baudrate : 100000u));
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate)
+{
+    i2c->baudrate = baudrate;
+    return baudrate;
+}
+
+void i2c_deinit(i2c_inst_t *i2c)
+{
+    (void)i2c;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop)
+{
+    (void)nostop;
+    pthread_mutex_lock(&i2c->lock);
+    esperar_fio(i2c, len);
+    int ret = (int)len;
+    if (!dispositivo_presente(i2c, addr))
+        ret = PICO_ERROR_GENERIC;
+    else if (addr == AHT20_ADDR)
+        aht20_escrever(src, len);
+    else if (addr == BMP280_ADDR)
+        bmp280_escrever(src, len);
+    pthread_mutex_unlock(&i2c->lock);
+    return ret;
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop)
+{
+    (void)nostop;
+    pthread_mutex_lock(&i2c->lock);
+    esperar_fio(i2c, len);
+    int ret = (int)len;
+    if (!dispositivo_presente(i2c, addr))
+        ret = PICO_ERROR_GENERIC;
+    else if (addr == AHT20_ADDR)
+        aht20_ler(dst, len);
+    else if (addr == BMP280_ADDR)
+        bmp280_ler(dst, len);
+    else
+        memset(dst, 0, len);
+    pthread_mutex_unlock(&i2c->lock);
+    return ret;
+}
@@ -0,0 +1,54 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+// FreeRTOS sobre POSIX para a simulação host: cada tarefa é uma pthread e
+// um tick equivale a 1/configTICK_RATE_HZ segundos do relógio monotônico.
+
+#include <stdint.h>
+#include <stddef.h>
+#include "FreeRTOSConfig.h"
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS (pdTRUE)
+#define pdFAIL (pdFALSE)
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+
+#ifndef pdMS_TO_TICKS
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t)(((TickType_t)(xTimeInMs) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+#endif
+
+#ifndef configRUN_TIME_COUNTER_TYPE
+#define configRUN_TIME_COUNTER_TYPE uint32_t
+#endif
+
+#ifndef configMAX_TASK_NAME_LEN
+#define configMAX_TASK_NAME_LEN 16
+#endif
+
+// Memória das versões Static das APIs: opaca como no kernel, com espaço para as
+// estruturas da simulação (conferido em freertos_posix.c)
+typedef struct { uint64_t reservado[32]; } StaticTask_t;
+typedef struct { uint64_t reservado[16]; } StaticSemaphore_t;
+typedef struct { uint64_t reservado[16]; } StaticEventGroup_t;
+
+void *pvPortMalloc(size_t xSize);
+void vPortFree(void *pv);
+size_t xPortGetFreeHeapSize(void);
+size_t xPortGetMinimumEverFreeHeapSize(void);
+
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+#define taskENTER_CRITICAL() vPortEnterCritical()
+#define taskEXIT_CRITICAL() vPortExitCritical()
+#define portYIELD_FROM_ISR(x) ((void)(x))
+#define portCHECK_IF_IN_ISR() 0  // Nenhum código do host roda em contexto de interrupção
+
+#endif // HOST_FREERTOS_H
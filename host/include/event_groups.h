@@ -0,0 +1,24 @@
+#ifndef HOST_EVENT_GROUPS_H
+#define HOST_EVENT_GROUPS_H
+
+#include "FreeRTOS.h"
+
+// Como no kernel com ticks de 32 bits: só os 24 bits menos significativos são eventos
+typedef TickType_t EventBits_t;
+typedef struct host_event_group *EventGroupHandle_t;
+
+#if configSUPPORT_DYNAMIC_ALLOCATION
+EventGroupHandle_t xEventGroupCreate(void);
+#endif
+#if configSUPPORT_STATIC_ALLOCATION
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *pxEventGroupBuffer);
+#endif
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet);
+BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet,
+                                     BaseType_t *pxHigherPriorityTaskWoken);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToClear);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToWaitFor,
+                                const BaseType_t xClearOnExit, const BaseType_t xWaitForAllBits,
+                                TickType_t xTicksToWait);
+
+#endif // HOST_EVENT_GROUPS_H
@@ -0,0 +1,28 @@
+#ifndef HOST_HARDWARE_I2C_H
+#define HOST_HARDWARE_I2C_H
+
+// Substituto host de hardware/i2c.h. Os barramentos são simulados com os
+// dispositivos da BitDogLab: AHT20 (0x38) e BMP280 (0x77) no i2c0 e o
+// SSD1306 (0x3C) no i2c1. Cada transação dorme o tempo que levaria no fio.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "pico/stdlib.h"
+
+typedef struct i2c_inst i2c_inst_t;
+
+extern i2c_inst_t i2c0_inst;
+extern i2c_inst_t i2c1_inst;
+
+#define i2c0 (&i2c0_inst)
+#define i2c1 (&i2c1_inst)
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+void i2c_deinit(i2c_inst_t *i2c);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+
+static inline uint i2c_hw_index(i2c_inst_t *i2c) { return i2c == i2c1 ? 1u : 0u; }
+
+#endif // HOST_HARDWARE_I2C_H
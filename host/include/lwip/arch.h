@@ -0,0 +1,18 @@
+#ifndef HOST_LWIP_ARCH_H
+#define HOST_LWIP_ARCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint8_t u8_t;
+typedef int8_t s8_t;
+typedef uint16_t u16_t;
+typedef int16_t s16_t;
+typedef uint32_t u32_t;
+typedef int32_t s32_t;
+typedef uint64_t u64_t;
+typedef uintptr_t mem_ptr_t;
+
+#define LWIP_UNUSED_ARG(x) (void)(x)
+
+#endif // HOST_LWIP_ARCH_H
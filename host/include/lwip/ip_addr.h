@@ -0,0 +1,19 @@
+#ifndef HOST_LWIP_IP_ADDR_H
+#define HOST_LWIP_IP_ADDR_H
+
+#include "lwip/arch.h"
+
+// Endereço IPv4 em ordem de bytes de rede, como no lwIP
+typedef struct ip_addr
+{
+    u32_t addr;
+} ip_addr_t;
+
+extern const ip_addr_t ip_addr_any;
+#define IP_ADDR_ANY (&ip_addr_any)
+#define ip_addr_copy(dest, src) ((dest) = (src))
+
+char *ipaddr_ntoa(const ip_addr_t *addr);
+#define ip4addr_ntoa(addr) ipaddr_ntoa(addr)
+
+#endif // HOST_LWIP_IP_ADDR_H
@@ -0,0 +1,14 @@
+#ifndef HOST_LWIP_MEMP_H
+#define HOST_LWIP_MEMP_H
+
+// Pools do lwIP simulados por lwip_posix.c, com os mesmos nomes do memp_std.h
+typedef enum
+{
+    MEMP_TCP_PCB,
+    MEMP_TCP_SEG,
+    MEMP_PBUF,
+    MEMP_PBUF_POOL,
+    MEMP_MAX
+} memp_t;
+
+#endif // HOST_LWIP_MEMP_H
@@ -0,0 +1,15 @@
+#ifndef HOST_LWIP_NETIF_H
+#define HOST_LWIP_NETIF_H
+
+#include "lwip/ip_addr.h"
+
+struct netif
+{
+    ip_addr_t ip_addr;
+    ip_addr_t netmask;
+    ip_addr_t gw;
+};
+
+extern struct netif *netif_default;
+
+#endif // HOST_LWIP_NETIF_H
@@ -0,0 +1,40 @@
+#ifndef HOST_LWIP_OPT_H
+#define HOST_LWIP_OPT_H
+
+// Carrega o lwipopts.h do projeto e completa com os padrões do lwIP 2.1,
+// para que a simulação respeite os mesmos limites de memória do firmware.
+
+#include "lwipopts.h"
+
+#ifndef MEM_SIZE
+#define MEM_SIZE 1600
+#endif
+#ifndef MEMP_NUM_PBUF
+#define MEMP_NUM_PBUF 16
+#endif
+#ifndef PBUF_POOL_SIZE
+#define PBUF_POOL_SIZE 16
+#endif
+#ifndef MEMP_NUM_TCP_PCB
+#define MEMP_NUM_TCP_PCB 5
+#endif
+#ifndef MEMP_NUM_TCP_SEG
+#define MEMP_NUM_TCP_SEG 16
+#endif
+#ifndef TCP_MSS
+#define TCP_MSS 536
+#endif
+#ifndef TCP_SND_BUF
+#define TCP_SND_BUF (2 * TCP_MSS)
+#endif
+#ifndef TCP_WND
+#define TCP_WND (4 * TCP_MSS)
+#endif
+#ifndef TCP_SND_QUEUELEN
+#define TCP_SND_QUEUELEN ((4 * (TCP_SND_BUF) + (TCP_MSS - 1)) / (TCP_MSS))
+#endif
+#ifndef TCP_TMR_INTERVAL
+#define TCP_TMR_INTERVAL 250
+#endif
+
+#endif // HOST_LWIP_OPT_H
@@ -0,0 +1,30 @@
+#ifndef HOST_LWIP_STATS_H
+#define HOST_LWIP_STATS_H
+
+#include "lwip/opt.h"
+#include "lwip/arch.h"
+#include "lwip/memp.h"
+
+// Subconjunto de lwip_stats (MEM_STATS e MEMP_STATS) preenchido pela simulação a
+// cada liberação do lock do lwIP
+typedef u16_t mem_size_t;
+
+struct stats_mem
+{
+    const char *name;
+    u16_t err;
+    mem_size_t avail;
+    mem_size_t used;
+    mem_size_t max;
+    u16_t illegal;
+};
+
+struct stats_
+{
+    struct stats_mem mem;
+    struct stats_mem *memp[MEMP_MAX];
+};
+
+extern struct stats_ lwip_stats;
+
+#endif // HOST_LWIP_STATS_H
@@ -0,0 +1,87 @@
+#ifndef HOST_LWIP_TCP_H
+#define HOST_LWIP_TCP_H
+
+// API "raw" de TCP do lwIP servida por sockets Linux não bloqueantes.
+// Os callbacks rodam na thread de rede com o lock do lwIP adquirido, como
+// no modo threadsafe_background do Pico SDK. tcp_write respeita TCP_SND_BUF,
+// TCP_SND_QUEUELEN, MEMP_NUM_TCP_SEG e (com TCP_WRITE_FLAG_COPY) o heap MEM_SIZE.
+
+#include "lwip/opt.h"
+#include "lwip/arch.h"
+#include "lwip/err.h"
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+
+struct tcp_pcb;
+
+typedef err_t (*tcp_accept_fn)(void *arg, struct tcp_pcb *newpcb, err_t err);
+typedef err_t (*tcp_recv_fn)(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err);
+typedef err_t (*tcp_sent_fn)(void *arg, struct tcp_pcb *tpcb, u16_t len);
+typedef err_t (*tcp_poll_fn)(void *arg, struct tcp_pcb *tpcb);
+typedef void (*tcp_err_fn)(void *arg, err_t err);
+
+struct host_tcp_seg;
+
+struct tcp_pcb
+{
+    ip_addr_t local_ip;
+    ip_addr_t remote_ip;
+    u16_t local_port;
+    u16_t remote_port;
+    u16_t snd_buf;
+    u16_t snd_queuelen;
+    u16_t mss;
+
+    // Campos internos da simulação
+    int fd;
+    u8_t state;
+    u8_t pollinterval;
+    u8_t polltmr;
+    u8_t listen_backlog;
+    u8_t fin_recebido;
+    u8_t no_pool;
+    void *callback_arg;
+    tcp_accept_fn accept;
+    tcp_recv_fn recv;
+    tcp_sent_fn sent;
+    tcp_poll_fn poll;
+    tcp_err_fn errf;
+    u32_t rcv_wnd;
+    struct pbuf *refused_data;
+    struct host_tcp_seg *unsent;
+    struct host_tcp_seg *unsent_tail;
+    u32_t acked_total;
+    u32_t acked_delivered;
+    u64_t ack_due_us;
+    struct tcp_pcb *next;
+};
+
+#define TCP_WRITE_FLAG_COPY 0x01
+#define TCP_WRITE_FLAG_MORE 0x02
+
+#define TCP_DEFAULT_LISTEN_BACKLOG 0xff
+
+struct tcp_pcb *tcp_new(void);
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port);
+struct tcp_pcb *tcp_listen_with_backlog(struct tcp_pcb *pcb, u8_t backlog);
+#define tcp_listen(pcb) tcp_listen_with_backlog(pcb, TCP_DEFAULT_LISTEN_BACKLOG)
+
+void tcp_arg(struct tcp_pcb *pcb, void *arg);
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn accept);
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv);
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent);
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err);
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval);
+
+err_t tcp_write(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags);
+err_t tcp_output(struct tcp_pcb *pcb);
+void tcp_recved(struct tcp_pcb *pcb, u16_t len);
+err_t tcp_close(struct tcp_pcb *pcb);
+void tcp_abort(struct tcp_pcb *pcb);
+
+#define tcp_sndbuf(pcb) ((pcb)->snd_buf)
+#define tcp_sndqueuelen(pcb) ((pcb)->snd_queuelen)
+#define tcp_mss(pcb) ((pcb)->mss)
+#define tcp_nagle_disable(pcb) ((void)(pcb))
+
+#endif // HOST_LWIP_TCP_H
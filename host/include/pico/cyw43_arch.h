@@ -0,0 +1,40 @@
+#ifndef HOST_PICO_CYW43_ARCH_H
+#define HOST_PICO_CYW43_ARCH_H
+
+// Substituto host de pico/cyw43_arch.h. O "Wi-Fi" está sempre conectado e
+// cyw43_arch_init() inicia a thread de rede que serve o lwIP sobre sockets.
+
+#include <stdint.h>
+#include "lwip/netif.h"
+
+#define CYW43_ITF_STA 0
+#define CYW43_ITF_AP 1
+
+#define CYW43_LINK_DOWN 0
+#define CYW43_LINK_JOIN 1
+#define CYW43_LINK_NOIP 2
+#define CYW43_LINK_UP 3
+
+#define CYW43_AUTH_OPEN 0
+#define CYW43_AUTH_WPA2_AES_PSK 0x00400004
+
+typedef struct
+{
+    int itf_state;
+} cyw43_t;
+
+extern cyw43_t cyw43_state;
+
+int cyw43_arch_init(void);
+void cyw43_arch_deinit(void);
+void cyw43_arch_enable_sta_mode(void);
+int cyw43_arch_wifi_connect_timeout_ms(const char *ssid, const char *pw, uint32_t auth, uint32_t timeout);
+int cyw43_arch_wifi_connect_async(const char *ssid, const char *pw, uint32_t auth);
+void cyw43_arch_poll(void);
+int cyw43_tcpip_link_status(cyw43_t *self, int itf);
+
+// Seção crítica do lwIP (no SDK: lock do modo threadsafe_background)
+void cyw43_arch_lwip_begin(void);
+void cyw43_arch_lwip_end(void);
+
+#endif // HOST_PICO_CYW43_ARCH_H
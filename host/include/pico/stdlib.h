@@ -0,0 +1,43 @@
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+// Substituto host (Linux) de pico/stdlib.h: tempo, sleeps e stdio.
+// Mantém apenas a parte da API do Pico SDK usada pelo firmware.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+typedef unsigned int uint;
+
+#define _u(x) x##u
+
+#define PICO_OK 0
+#define PICO_ERROR_GENERIC -1
+#define PICO_ERROR_TIMEOUT -2
+
+// Tempo absoluto em microssegundos desde o "boot" (início do processo)
+typedef uint64_t absolute_time_t;
+
+uint64_t time_us_64(void);
+static inline uint32_t time_us_32(void) { return (uint32_t)time_us_64(); }
+
+static inline absolute_time_t get_absolute_time(void) { return time_us_64(); }
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) { return time_us_64() + (uint64_t)ms * 1000u; }
+static inline absolute_time_t make_timeout_time_us(uint64_t us) { return time_us_64() + us; }
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) { return (int64_t)(to - from); }
+static inline uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000u); }
+static inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+void busy_wait_us(uint64_t us);
+
+static inline void tight_loop_contents(void) {}
+
+bool stdio_init_all(void);
+
+#include "hardware/gpio.h"
+
+#endif // HOST_PICO_STDLIB_H
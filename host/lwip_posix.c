@@ -0,0 +1,946 @@
+// Simulação host do cyw43_arch + lwIP: a API raw de TCP e os pbufs do lwIP
+// servidos por sockets Linux, com os limites de memória do lwipopts.h.
+//
+// Uma thread de rede ("lwip") faz poll() nos sockets e chama os callbacks
+// com o lock do lwIP adquirido. Bytes escritos no socket do kernel são
+// confirmados (callback sent) após WS_HOST_RTT_MS milissegundos (padrão 0).
+// WS_HOST_TCP_PORT troca a porta de todo tcp_bind (ex.: 8080 sem root).
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "lwip/tcp.h"
+#include "lwip/pbuf.h"
+#include "lwip/netif.h"
+#include "lwip/stats.h"
+
+#define ESTADO_FECHADO 0
+#define ESTADO_ESCUTA 1
+#define ESTADO_CONECTADO 2
+#define ESTADO_FECHANDO 3
+#define ESTADO_MORTO 4
+
+#define MAX_PCBS_POLL 64
+#define POLL_TICK_US (2u * TCP_TMR_INTERVAL * 1000u)
+
+// Custo aproximado no heap do lwIP de cada segmento (pbuf + cabeçalhos TCP/IP)
+#define CUSTO_CABECALHO_SEG 80u
+
+struct host_tcp_seg
+{
+    struct host_tcp_seg *next;
+    const u8_t *dados;
+    u16_t len;
+    u16_t enviado;
+    u16_t confirmado;
+    bool copia;
+    size_t custo_mem;
+};
+
+cyw43_t cyw43_state;
+const ip_addr_t ip_addr_any = {0};
+static struct netif netif_sim;
+struct netif *netif_default = &netif_sim;
+
+static pthread_mutex_t lwip_lock;
+static pthread_once_t lwip_once = PTHREAD_ONCE_INIT;
+static pthread_t thread_rede;
+static bool thread_rede_ativa = false;
+static int pipe_despertar[2] = {-1, -1};
+static struct tcp_pcb *pcbs = NULL;
+static uint64_t rtt_us = 0;
+
+// Contabilidade dos pools do lwIP
+static size_t mem_usado = 0;
+static int segs_usados = 0;
+static int pbufs_pool_usados = 0;
+static int pbufs_ref_usados = 0;
+static int pcbs_ativos = 0;
+
+static struct stats_mem stats_pools[MEMP_MAX] = {
+    [MEMP_TCP_PCB] = {.name = "TCP_PCB", .avail = MEMP_NUM_TCP_PCB},
+    [MEMP_TCP_SEG] = {.name = "TCP_SEG", .avail = MEMP_NUM_TCP_SEG},
+    [MEMP_PBUF] = {.name = "PBUF_REF/ROM", .avail = MEMP_NUM_PBUF},
+    [MEMP_PBUF_POOL] = {.name = "PBUF_POOL", .avail = PBUF_POOL_SIZE},
+};
+struct stats_ lwip_stats = {
+    .mem = {.name = "MEM", .avail = MEM_SIZE},
+    .memp = {&stats_pools[MEMP_TCP_PCB], &stats_pools[MEMP_TCP_SEG], &stats_pools[MEMP_PBUF], &stats_pools[MEMP_PBUF_POOL]},
+};
+
+// ===================== LOCK E INICIALIZAÇÃO =====================
+static void iniciar_lwip(void)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&lwip_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    if (pipe2(pipe_despertar, O_NONBLOCK | O_CLOEXEC) != 0)
+        perror("[HOST] pipe2");
+
+    netif_sim.ip_addr.addr = htonl(INADDR_LOOPBACK);
+    netif_sim.netmask.addr = htonl(0xFF000000u);
+
+    const char *rtt = getenv("WS_HOST_RTT_MS");
+    if (rtt)
+        rtt_us = strtoull(rtt, NULL, 10) * 1000u;
+}
+
+static void lwip_lock_adquirir(void)
+{
+    pthread_once(&lwip_once, iniciar_lwip);
+    pthread_mutex_lock(&lwip_lock);
+}
+
+static void registrar_uso(struct stats_mem *s, size_t usado)
+{
+    s->used = (mem_size_t)usado;
+    if (s->used > s->max)
+        s->max = s->used;
+}
+
+// Toda alteração dos contadores acontece com o lock tomado: lwip_stats é
+// atualizado ao liberá-lo
+static void lwip_lock_liberar(void)
+{
+    registrar_uso(&lwip_stats.mem, mem_usado);
+    registrar_uso(&stats_pools[MEMP_TCP_PCB], (size_t)pcbs_ativos);
+    registrar_uso(&stats_pools[MEMP_TCP_SEG], (size_t)segs_usados);
+    registrar_uso(&stats_pools[MEMP_PBUF], (size_t)pbufs_ref_usados);
+    registrar_uso(&stats_pools[MEMP_PBUF_POOL], (size_t)pbufs_pool_usados);
+    pthread_mutex_unlock(&lwip_lock);
+}
+
+static void despertar_rede(void)
+{
+    if (pipe_despertar[1] >= 0)
+    {
+        char c = 0;
+        (void)!write(pipe_despertar[1], &c, 1);
+    }
+}
+
+void cyw43_arch_lwip_begin(void)
+{
+    lwip_lock_adquirir();
+}
+
+void cyw43_arch_lwip_end(void)
+{
+    lwip_lock_liberar();
+}
+
+char *ipaddr_ntoa(const ip_addr_t *addr)
+{
+    static char buf[INET_ADDRSTRLEN];
+    struct in_addr in = {.s_addr = addr ? addr->addr : 0};
+    inet_ntop(AF_INET, &in, buf, sizeof(buf));
+    return buf;
+}
+
+// ===================== PBUF =====================
+static size_t alinhar(size_t n)
+{
+    return (n + MEM_ALIGNMENT - 1) & ~(size_t)(MEM_ALIGNMENT - 1);
+}
+
+static bool mem_reservar(size_t n)
+{
+    if (mem_usado + n > MEM_SIZE)
+    {
+        lwip_stats.mem.err++;
+        return false;
+    }
+    mem_usado += n;
+    return true;
+}
+
+struct pbuf *pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
+{
+    (void)layer;
+    struct pbuf *p = NULL;
+    lwip_lock_adquirir();
+    if (type == PBUF_RAM)
+    {
+        if (mem_reservar(alinhar(sizeof(struct pbuf)) + alinhar(length)))
+        {
+            p = calloc(1, sizeof(struct pbuf) + length);
+            if (p)
+                p->payload = p + 1;
+            else
+                mem_usado -= alinhar(sizeof(struct pbuf)) + alinhar(length);
+        }
+        if (p)
+            p->tot_len = p->len = length;
+    }
+    else if (type == PBUF_POOL)
+    {
+        // Cadeia de buffers do pool com até TCP_MSS bytes cada
+        int necessarios = length ? (length + TCP_MSS - 1) / TCP_MSS : 1;
+        if (pbufs_pool_usados + necessarios <= PBUF_POOL_SIZE)
+        {
+            struct pbuf **fim = &p;
+            u16_t restante = length;
+            for (int i = 0; i < necessarios; i++)
+            {
+                u16_t len = restante > TCP_MSS ? TCP_MSS : restante;
+                struct pbuf *q = calloc(1, sizeof(struct pbuf) + TCP_MSS);
+                q->payload = q + 1;
+                q->len = len;
+                q->tot_len = restante;
+                q->type_internal = PBUF_POOL;
+                q->ref = 1;
+                *fim = q;
+                fim = &q->next;
+                restante -= len;
+                pbufs_pool_usados++;
+            }
+        }
+        else
+        {
+            stats_pools[MEMP_PBUF_POOL].err++;
+        }
+        lwip_lock_liberar();
+        return p;
+    }
+    else
+    {
+        if (pbufs_ref_usados < MEMP_NUM_PBUF)
+        {
+            p = calloc(1, sizeof(struct pbuf));
+            if (p)
+            {
+                pbufs_ref_usados++;
+                p->tot_len = p->len = length;
+            }
+        }
+        else
+        {
+            stats_pools[MEMP_PBUF].err++;
+        }
+    }
+    if (p)
+    {
+        p->type_internal = (u8_t)type;
+        p->ref = 1;
+    }
+    lwip_lock_liberar();
+    return p;
+}
+
+u8_t pbuf_free(struct pbuf *p)
+{
+    u8_t liberados = 0;
+    lwip_lock_adquirir();
+    while (p)
+    {
+        if (--p->ref > 0)
+            break;
+        struct pbuf *prox = p->next;
+        if (p->type_internal == PBUF_POOL)
+            pbufs_pool_usados--;
+        else if (p->type_internal == PBUF_RAM)
+            mem_usado -= alinhar(sizeof(struct pbuf)) + alinhar((u16_t)((u8_t *)p->payload - (u8_t *)(p + 1)) + p->len);
+        else
+            pbufs_ref_usados--;
+        free(p);
+        liberados++;
+        p = prox;
+    }
+    lwip_lock_liberar();
+    return liberados;
+}
+
+void pbuf_ref(struct pbuf *p)
+{
+    if (p)
+        p->ref++;
+}
+
+void pbuf_cat(struct pbuf *h, struct pbuf *t)
+{
+    // Como no lwIP: a referência de t passa a pertencer à cadeia h
+    for (; h->next; h = h->next)
+        h->tot_len += t->tot_len;
+    h->tot_len += t->tot_len;
+    h->next = t;
+}
+
+u8_t pbuf_remove_header(struct pbuf *p, size_t header_size)
+{
+    if (!p || header_size > p->len)
+        return 1;
+    p->payload = (u8_t *)p->payload + header_size;
+    p->len -= (u16_t)header_size;
+    p->tot_len -= (u16_t)header_size;
+    return 0;
+}
+
+struct pbuf *pbuf_free_header(struct pbuf *q, u16_t size)
+{
+    while (q && size > 0)
+    {
+        if (size >= q->len)
+        {
+            // Buffer inteiro consumido: solta só este elo da cadeia
+            struct pbuf *prox = q->next;
+            size -= q->len;
+            q->next = NULL;
+            pbuf_free(q);
+            q = prox;
+        }
+        else
+        {
+            pbuf_remove_header(q, size);
+            size = 0;
+        }
+    }
+    return q;
+}
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset)
+{
+    u16_t copiados = 0;
+    u8_t *dst = dataptr;
+    for (; p && len > 0; p = p->next)
+    {
+        if (offset >= p->len)
+        {
+            offset -= p->len;
+            continue;
+        }
+        u16_t n = p->len - offset;
+        if (n > len)
+            n = len;
+        memcpy(dst + copiados, (const u8_t *)p->payload + offset, n);
+        copiados += n;
+        len -= n;
+        offset = 0;
+    }
+    return copiados;
+}
+
+u8_t pbuf_get_at(const struct pbuf *p, u16_t offset)
+{
+    for (; p; p = p->next)
+    {
+        if (offset < p->len)
+            return ((const u8_t *)p->payload)[offset];
+        offset -= p->len;
+    }
+    return 0;
+}
+
+// ===================== SEGMENTOS DE ENVIO =====================
+static size_t custo_segmento(u16_t len, bool copia)
+{
+    return CUSTO_CABECALHO_SEG + (copia ? alinhar(len) : 0);
+}
+
+static void seg_liberar(struct host_tcp_seg *seg)
+{
+    mem_usado -= seg->custo_mem;
+    segs_usados--;
+    if (!seg->copia)
+        pbufs_ref_usados--;
+    free(seg);
+}
+
+static void pcb_liberar_segs(struct tcp_pcb *pcb)
+{
+    while (pcb->unsent)
+    {
+        struct host_tcp_seg *seg = pcb->unsent;
+        pcb->unsent = seg->next;
+        seg_liberar(seg);
+    }
+    pcb->unsent_tail = NULL;
+    pcb->snd_queuelen = 0;
+}
+
+static void pcb_matar(struct tcp_pcb *pcb, err_t motivo)
+{
+    tcp_err_fn errf = pcb->errf;
+    void *arg = pcb->callback_arg;
+    if (pcb->fd >= 0)
+    {
+        struct linger l = {.l_onoff = 1, .l_linger = 0};
+        setsockopt(pcb->fd, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+        close(pcb->fd);
+        pcb->fd = -1;
+    }
+    pcb->state = ESTADO_MORTO;
+    if (errf)
+        errf(arg, motivo);
+}
+
+// Escreve no socket os segmentos ainda não enviados
+static void pcb_descarregar(struct tcp_pcb *pcb)
+{
+    if (pcb->fd < 0 || (pcb->state != ESTADO_CONECTADO && pcb->state != ESTADO_FECHANDO))
+        return;
+    for (struct host_tcp_seg *seg = pcb->unsent; seg; seg = seg->next)
+    {
+        if (seg->enviado == seg->len)
+            continue;
+        ssize_t n = send(pcb->fd, seg->dados + seg->enviado, seg->len - seg->enviado, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                pcb_matar(pcb, ERR_RST);
+            return;
+        }
+        seg->enviado += (u16_t)n;
+        if (pcb->acked_total == pcb->acked_delivered)
+            pcb->ack_due_us = time_us_64() + rtt_us;
+        pcb->acked_total += (u32_t)n;
+        if (seg->enviado < seg->len)
+            return;
+    }
+}
+
+// Entrega ao app as confirmações cujo "RTT" já passou
+static void pcb_confirmar(struct tcp_pcb *pcb)
+{
+    if (pcb->acked_total == pcb->acked_delivered || time_us_64() < pcb->ack_due_us)
+        return;
+    u32_t n = pcb->acked_total - pcb->acked_delivered;
+    pcb->acked_delivered = pcb->acked_total;
+
+    u32_t restante = n;
+    while (restante && pcb->unsent)
+    {
+        struct host_tcp_seg *seg = pcb->unsent;
+        u16_t falta = seg->len - seg->confirmado;
+        if (restante < falta)
+        {
+            seg->confirmado += (u16_t)restante;
+            break;
+        }
+        restante -= falta;
+        pcb->unsent = seg->next;
+        if (!pcb->unsent)
+            pcb->unsent_tail = NULL;
+        pcb->snd_queuelen--;
+        seg_liberar(seg);
+    }
+    pcb->snd_buf += (u16_t)n;
+
+    while (n > 0 && pcb->state == ESTADO_CONECTADO && pcb->sent)
+    {
+        u16_t parte = n > 0xFFFF ? 0xFFFF : (u16_t)n;
+        if (pcb->sent(pcb->callback_arg, pcb, parte) == ERR_ABRT)
+            break;
+        n -= parte;
+    }
+}
+
+// ===================== API TCP =====================
+struct tcp_pcb *tcp_new(void)
+{
+    struct tcp_pcb *pcb = NULL;
+    lwip_lock_adquirir();
+    if (pcbs_ativos >= MEMP_NUM_TCP_PCB)
+        stats_pools[MEMP_TCP_PCB].err++;
+    else
+    {
+        pcb = calloc(1, sizeof(*pcb));
+        if (pcb)
+        {
+            pcb->fd = -1;
+            pcb->snd_buf = TCP_SND_BUF;
+            pcb->mss = TCP_MSS;
+            pcb->rcv_wnd = TCP_WND;
+            pcb->no_pool = 1;
+            pcbs_ativos++;
+        }
+    }
+    lwip_lock_liberar();
+    return pcb;
+}
+
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port)
+{
+    const char *porta_env = getenv("WS_HOST_TCP_PORT");
+    u16_t porta = porta_env ? (u16_t)atoi(porta_env) : port;
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return ERR_MEM;
+    int um = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &um, sizeof(um));
+    struct sockaddr_in sa = {.sin_family = AF_INET, .sin_port = htons(porta)};
+    sa.sin_addr.s_addr = ipaddr ? ipaddr->addr : INADDR_ANY;
+    if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+    {
+        printf("[HOST] bind na porta %u falhou: %s\n", porta, strerror(errno));
+        close(fd);
+        return ERR_USE;
+    }
+    lwip_lock_adquirir();
+    pcb->fd = fd;
+    pcb->local_port = porta;
+    lwip_lock_liberar();
+    if (porta != port)
+        printf("[HOST] Porta TCP %u servida na porta %u do host.\n", port, porta);
+    return ERR_OK;
+}
+
+struct tcp_pcb *tcp_listen_with_backlog(struct tcp_pcb *pcb, u8_t backlog)
+{
+    if (pcb->fd < 0 || listen(pcb->fd, backlog) != 0)
+        return NULL;
+    lwip_lock_adquirir();
+    // No lwIP o PCB de escuta sai de um pool próprio e libera o PCB original
+    pcbs_ativos--;
+    pcb->no_pool = 0;
+    pcb->state = ESTADO_ESCUTA;
+    pcb->listen_backlog = backlog;
+    pcb->next = pcbs;
+    pcbs = pcb;
+    lwip_lock_liberar();
+    despertar_rede();
+    return pcb;
+}
+
+void tcp_arg(struct tcp_pcb *pcb, void *arg)
+{
+    pcb->callback_arg = arg;
+}
+
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn accept)
+{
+    pcb->accept = accept;
+}
+
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv)
+{
+    pcb->recv = recv;
+}
+
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent)
+{
+    pcb->sent = sent;
+}
+
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err)
+{
+    pcb->errf = err;
+}
+
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval)
+{
+    pcb->poll = poll;
+    pcb->pollinterval = interval;
+    pcb->polltmr = 0;
+}
+
+err_t tcp_write(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags)
+{
+    if (len == 0)
+        return ERR_OK;
+    err_t err = ERR_OK;
+    lwip_lock_adquirir();
+    bool copia = (apiflags & TCP_WRITE_FLAG_COPY) != 0;
+    int nsegs = (len + pcb->mss - 1) / pcb->mss;
+    size_t custo = 0;
+    for (u16_t off = 0; off < len; off += pcb->mss)
+        custo += custo_segmento(len - off > pcb->mss ? pcb->mss : len - off, copia);
+
+    if (pcb->state != ESTADO_CONECTADO)
+        err = ERR_CONN;
+    else if (len > pcb->snd_buf || pcb->snd_queuelen + nsegs > TCP_SND_QUEUELEN)
+        err = ERR_MEM;
+    else if (segs_usados + nsegs > MEMP_NUM_TCP_SEG)
+    {
+        stats_pools[MEMP_TCP_SEG].err++;
+        err = ERR_MEM;
+    }
+    else if (!copia && pbufs_ref_usados + nsegs > MEMP_NUM_PBUF)
+    {
+        stats_pools[MEMP_PBUF].err++;
+        err = ERR_MEM;
+    }
+    else if (!mem_reservar(custo))
+        err = ERR_MEM;
+
+    if (err == ERR_OK)
+    {
+        const u8_t *dados = dataptr;
+        u16_t restante = len;
+        for (int i = 0; i < nsegs; i++)
+        {
+            u16_t n = restante > pcb->mss ? pcb->mss : restante;
+            struct host_tcp_seg *seg = calloc(1, sizeof(*seg) + (copia ? n : 0));
+            seg->len = n;
+            seg->copia = copia;
+            seg->custo_mem = custo_segmento(n, copia);
+            if (copia)
+            {
+                memcpy(seg + 1, dados, n);
+                seg->dados = (const u8_t *)(seg + 1);
+            }
+            else
+            {
+                seg->dados = dados;
+                pbufs_ref_usados++;
+            }
+            segs_usados++;
+            if (pcb->unsent_tail)
+                pcb->unsent_tail->next = seg;
+            else
+                pcb->unsent = seg;
+            pcb->unsent_tail = seg;
+            dados += n;
+            restante -= n;
+        }
+        pcb->snd_buf -= len;
+        pcb->snd_queuelen += (u16_t)nsegs;
+    }
+    lwip_lock_liberar();
+    return err;
+}
+
+err_t tcp_output(struct tcp_pcb *pcb)
+{
+    lwip_lock_adquirir();
+    pcb_descarregar(pcb);
+    lwip_lock_liberar();
+    despertar_rede();
+    return ERR_OK;
+}
+
+void tcp_recved(struct tcp_pcb *pcb, u16_t len)
+{
+    lwip_lock_adquirir();
+    if (!pcb->fin_recebido)
+    {
+        pcb->rcv_wnd += len;
+        if (pcb->rcv_wnd > TCP_WND)
+            pcb->rcv_wnd = TCP_WND;
+    }
+    lwip_lock_liberar();
+    despertar_rede();
+}
+
+err_t tcp_close(struct tcp_pcb *pcb)
+{
+    lwip_lock_adquirir();
+    if (pcb->state == ESTADO_ESCUTA || pcb->state == ESTADO_FECHADO)
+    {
+        if (pcb->fd >= 0)
+            close(pcb->fd);
+        pcb->fd = -1;
+        if (pcb->state == ESTADO_FECHADO)
+        {
+            // PCB nunca entrou na lista: libera direto
+            pcbs_ativos--;
+            free(pcb);
+            lwip_lock_liberar();
+            return ERR_OK;
+        }
+        pcb->state = ESTADO_MORTO;
+    }
+    else if (pcb->state == ESTADO_CONECTADO)
+    {
+        pcb->state = ESTADO_FECHANDO;
+        pcb->recv = NULL;
+        pcb->sent = NULL;
+        pcb->poll = NULL;
+        pcb->errf = NULL;
+        pcb_descarregar(pcb);
+    }
+    lwip_lock_liberar();
+    despertar_rede();
+    return ERR_OK;
+}
+
+void tcp_abort(struct tcp_pcb *pcb)
+{
+    lwip_lock_adquirir();
+    if (pcb->state != ESTADO_MORTO)
+        pcb_matar(pcb, ERR_ABRT);
+    lwip_lock_liberar();
+    despertar_rede();
+}
+
+// ===================== THREAD DE REDE =====================
+static void pcb_entregar_recv(struct tcp_pcb *pcb, struct pbuf *p)
+{
+    if (!pcb->recv)
+    {
+        // tcp_recv_null do lwIP: descarta dados e fecha no FIN
+        if (p)
+        {
+            tcp_recved(pcb, p->tot_len);
+            pbuf_free(p);
+        }
+        else
+        {
+            tcp_close(pcb);
+        }
+        return;
+    }
+    err_t r = pcb->recv(pcb->callback_arg, pcb, p, ERR_OK);
+    if (r != ERR_OK && r != ERR_ABRT && p && pcb->state == ESTADO_CONECTADO)
+        pcb->refused_data = p;
+}
+
+static void pcb_ler(struct tcp_pcb *pcb)
+{
+    int livres = PBUF_POOL_SIZE - pbufs_pool_usados;
+    u32_t max = pcb->rcv_wnd;
+    if (max > (u32_t)livres * TCP_MSS)
+        max = (u32_t)livres * TCP_MSS;
+    if (max > 0xFFFF)
+        max = 0xFFFF;
+    if (max == 0)
+        return;
+
+    u8_t buf[0xFFFF];
+    ssize_t n = recv(pcb->fd, buf, max, MSG_DONTWAIT);
+    if (n < 0)
+    {
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            pcb_matar(pcb, ERR_RST);
+        return;
+    }
+    if (n == 0)
+    {
+        pcb->rcv_wnd = 0;
+        pcb->fin_recebido = 1;
+        // O FIN do cliente chega depois do ACK de tudo que ele já leu
+        pcb->ack_due_us = 0;
+        pcb_confirmar(pcb);
+        if (pcb->state == ESTADO_CONECTADO)
+            pcb_entregar_recv(pcb, NULL);
+        return;
+    }
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, (u16_t)n, PBUF_POOL);
+    if (!p)
+        return;
+    u16_t off = 0;
+    for (struct pbuf *q = p; q; q = q->next)
+    {
+        memcpy(q->payload, buf + off, q->len);
+        off += q->len;
+    }
+    pcb->rcv_wnd -= (u32_t)n;
+    pcb_entregar_recv(pcb, p);
+}
+
+static void aceitar_conexoes(struct tcp_pcb *escuta)
+{
+    while (pcbs_ativos < MEMP_NUM_TCP_PCB && escuta->state == ESTADO_ESCUTA)
+    {
+        struct sockaddr_in sa;
+        socklen_t salen = sizeof(sa);
+        int fd = accept4(escuta->fd, (struct sockaddr *)&sa, &salen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+        int um = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+
+        struct tcp_pcb *pcb = calloc(1, sizeof(*pcb));
+        pcb->fd = fd;
+        pcb->state = ESTADO_CONECTADO;
+        pcb->snd_buf = TCP_SND_BUF;
+        pcb->mss = TCP_MSS;
+        pcb->rcv_wnd = TCP_WND;
+        pcb->remote_ip.addr = sa.sin_addr.s_addr;
+        pcb->remote_port = ntohs(sa.sin_port);
+        pcb->local_ip = netif_sim.ip_addr;
+        pcb->local_port = escuta->local_port;
+        pcb->callback_arg = escuta->callback_arg;
+        pcb->next = pcbs;
+        pcbs = pcb;
+        pcb->no_pool = 1;
+        pcbs_ativos++;
+
+        err_t r = escuta->accept ? escuta->accept(escuta->callback_arg, pcb, ERR_OK) : ERR_VAL;
+        if (r != ERR_OK && r != ERR_ABRT && pcb->state == ESTADO_CONECTADO)
+            pcb_matar(pcb, ERR_ABRT);
+    }
+}
+
+static void remover_mortos(void)
+{
+    struct tcp_pcb **pp = &pcbs;
+    while (*pp)
+    {
+        struct tcp_pcb *pcb = *pp;
+        if (pcb->state == ESTADO_FECHANDO && pcb->unsent == NULL)
+        {
+            close(pcb->fd);
+            pcb->fd = -1;
+            pcb->state = ESTADO_MORTO;
+        }
+        if (pcb->state != ESTADO_MORTO)
+        {
+            pp = &pcb->next;
+            continue;
+        }
+        *pp = pcb->next;
+        if (pcb->fd >= 0)
+            close(pcb->fd);
+        pcb_liberar_segs(pcb);
+        if (pcb->refused_data)
+            pbuf_free(pcb->refused_data);
+        if (pcb->no_pool)
+            pcbs_ativos--;
+        free(pcb);
+    }
+}
+
+static void *executar_rede(void *arg)
+{
+    (void)arg;
+    struct pollfd fds[MAX_PCBS_POLL + 1];
+    struct tcp_pcb *donos[MAX_PCBS_POLL + 1];
+    uint64_t proximo_tick = time_us_64() + POLL_TICK_US;
+
+    while (1)
+    {
+        lwip_lock_adquirir();
+        remover_mortos();
+        int nfds = 0;
+        fds[nfds].fd = pipe_despertar[0];
+        fds[nfds].events = POLLIN;
+        donos[nfds++] = NULL;
+        uint64_t agora = time_us_64();
+        uint64_t prazo = proximo_tick;
+        for (struct tcp_pcb *pcb = pcbs; pcb && nfds <= MAX_PCBS_POLL; pcb = pcb->next)
+        {
+            short eventos = 0;
+            if (pcb->state == ESTADO_ESCUTA && pcbs_ativos < MEMP_NUM_TCP_PCB)
+                eventos = POLLIN;
+            else if (pcb->state == ESTADO_CONECTADO || pcb->state == ESTADO_FECHANDO)
+            {
+                if (pcb->state == ESTADO_CONECTADO && !pcb->refused_data && pcb->rcv_wnd > 0 &&
+                    pbufs_pool_usados < PBUF_POOL_SIZE)
+                    eventos |= POLLIN;
+                for (struct host_tcp_seg *s = pcb->unsent; s; s = s->next)
+                    if (s->enviado < s->len)
+                    {
+                        eventos |= POLLOUT;
+                        break;
+                    }
+                if (pcb->acked_total != pcb->acked_delivered && pcb->ack_due_us < prazo)
+                    prazo = pcb->ack_due_us;
+                if (pcb->refused_data)
+                    prazo = agora;
+            }
+            if (pcb->fd < 0)
+                continue;
+            fds[nfds].fd = pcb->fd;
+            fds[nfds].events = eventos;
+            donos[nfds++] = pcb;
+        }
+        lwip_lock_liberar();
+
+        int espera_ms = prazo > agora ? (int)((prazo - agora + 999) / 1000) : 0;
+        poll(fds, (nfds_t)nfds, espera_ms);
+
+        lwip_lock_adquirir();
+        if (fds[0].revents & POLLIN)
+        {
+            char lixo[64];
+            while (read(pipe_despertar[0], lixo, sizeof(lixo)) > 0)
+            {
+            }
+        }
+        for (int i = 1; i < nfds; i++)
+        {
+            struct tcp_pcb *pcb = donos[i];
+            if (pcb->state == ESTADO_ESCUTA && (fds[i].revents & POLLIN))
+                aceitar_conexoes(pcb);
+            else if (pcb->state == ESTADO_CONECTADO && (fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                pcb_ler(pcb);
+        }
+
+        bool tick = time_us_64() >= proximo_tick;
+        if (tick)
+            proximo_tick += POLL_TICK_US;
+        for (struct tcp_pcb *pcb = pcbs; pcb; pcb = pcb->next)
+        {
+            if (pcb->state != ESTADO_CONECTADO && pcb->state != ESTADO_FECHANDO)
+                continue;
+            if (pcb->refused_data && pcb->state == ESTADO_CONECTADO)
+            {
+                struct pbuf *p = pcb->refused_data;
+                pcb->refused_data = NULL;
+                pcb_entregar_recv(pcb, p);
+            }
+            pcb_descarregar(pcb);
+            pcb_confirmar(pcb);
+            if (tick && pcb->state == ESTADO_CONECTADO && pcb->poll && ++pcb->polltmr >= pcb->pollinterval)
+            {
+                pcb->polltmr = 0;
+                pcb->poll(pcb->callback_arg, pcb);
+            }
+        }
+        lwip_lock_liberar();
+    }
+    return NULL;
+}
+
+// ===================== CYW43 =====================
+int cyw43_arch_init(void)
+{
+    lwip_lock_adquirir();
+    if (!thread_rede_ativa)
+    {
+        thread_rede_ativa = pthread_create(&thread_rede, NULL, executar_rede, NULL) == 0;
+        if (thread_rede_ativa)
+            pthread_setname_np(thread_rede, "lwip");
+    }
+    lwip_lock_liberar();
+    return thread_rede_ativa ? 0 : -1;
+}
+
+void cyw43_arch_deinit(void)
+{
+}
+
+void cyw43_arch_enable_sta_mode(void)
+{
+}
+
+int cyw43_arch_wifi_connect_timeout_ms(const char *ssid, const char *pw, uint32_t auth, uint32_t timeout)
+{
+    (void)pw;
+    (void)auth;
+    (void)timeout;
+    printf("[HOST] Wi-Fi simulado: associado a \"%s\".\n", ssid);
+    return 0;
+}
+
+int cyw43_arch_wifi_connect_async(const char *ssid, const char *pw, uint32_t auth)
+{
+    return cyw43_arch_wifi_connect_timeout_ms(ssid, pw, auth, 0);
+}
+
+void cyw43_arch_poll(void)
+{
+}
+
+int cyw43_tcpip_link_status(cyw43_t *self, int itf)
+{
+    (void)self;
+    (void)itf;
+    return CYW43_LINK_UP;
+}
@@ -0,0 +1,195 @@
+// Simulação host: tempo, stdio, GPIO, PWM e bootrom do Pico SDK.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include "pico/stdlib.h"
+#include "pico/bootrom.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+
+#define NUM_GPIOS 30
+
+// ===================== TEMPO =====================
+static uint64_t boot_us;
+static pthread_once_t boot_once = PTHREAD_ONCE_INIT;
+
+static uint64_t monotonic_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static void marcar_boot(void)
+{
+    boot_us = monotonic_us();
+}
+
+uint64_t time_us_64(void)
+{
+    pthread_once(&boot_once, marcar_boot);
+    return monotonic_us() - boot_us;
+}
+
+void sleep_us(uint64_t us)
+{
+    struct timespec ts = {.tv_sec = (time_t)(us / 1000000u), .tv_nsec = (long)(us % 1000000u) * 1000};
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+    {
+    }
+}
+
+void sleep_ms(uint32_t ms)
+{
+    sleep_us((uint64_t)ms * 1000u);
+}
+
+void busy_wait_us(uint64_t us)
+{
+    uint64_t fim = time_us_64() + us;
+    while (time_us_64() < fim)
+    {
+    }
+}
+
+bool stdio_init_all(void)
+{
+    pthread_once(&boot_once, marcar_boot);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    return true;
+}
+
+// ===================== GPIO =====================
+static bool gpio_valor[NUM_GPIOS];
+static bool gpio_saida[NUM_GPIOS];
+static uint32_t gpio_irq_mask[NUM_GPIOS];
+static gpio_irq_callback_t gpio_callback;
+static pthread_once_t stdin_once = PTHREAD_ONCE_INIT;
+
+void gpio_init(uint gpio)
+{
+    if (gpio < NUM_GPIOS)
+    {
+        gpio_valor[gpio] = false;
+        gpio_saida[gpio] = false;
+    }
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn)
+{
+    (void)gpio;
+    (void)fn;
+}
+
+void gpio_set_dir(uint gpio, bool out)
+{
+    if (gpio < NUM_GPIOS)
+        gpio_saida[gpio] = out;
+}
+
+void gpio_put(uint gpio, bool value)
+{
+    if (gpio < NUM_GPIOS)
+        gpio_valor[gpio] = value;
+}
+
+bool gpio_get(uint gpio)
+{
+    return gpio < NUM_GPIOS ? gpio_valor[gpio] : false;
+}
+
+void gpio_pull_up(uint gpio)
+{
+    if (gpio < NUM_GPIOS && !gpio_saida[gpio])
+        gpio_valor[gpio] = true;
+}
+
+void gpio_pull_down(uint gpio)
+{
+    if (gpio < NUM_GPIOS && !gpio_saida[gpio])
+        gpio_valor[gpio] = false;
+}
+
+// Cada linha do stdin com um número de GPIO simula uma borda de descida nele
+static void *thread_stdin_gpio(void *arg)
+{
+    (void)arg;
+    char linha[32];
+    while (fgets(linha, sizeof(linha), stdin))
+    {
+        char *fim;
+        long gpio = strtol(linha, &fim, 10);
+        if (fim == linha || gpio < 0 || gpio >= NUM_GPIOS)
+            continue;
+        if ((gpio_irq_mask[gpio] & GPIO_IRQ_EDGE_FALL) && gpio_callback)
+            gpio_callback((uint)gpio, GPIO_IRQ_EDGE_FALL);
+    }
+    return NULL;
+}
+
+static void iniciar_thread_stdin(void)
+{
+    pthread_t t;
+    if (pthread_create(&t, NULL, thread_stdin_gpio, NULL) == 0)
+    {
+        pthread_setname_np(t, "gpio-stdin");
+        pthread_detach(t);
+    }
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled)
+{
+    if (gpio >= NUM_GPIOS)
+        return;
+    if (enabled)
+        gpio_irq_mask[gpio] |= event_mask;
+    else
+        gpio_irq_mask[gpio] &= ~event_mask;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback)
+{
+    gpio_callback = callback;
+    gpio_set_irq_enabled(gpio, event_mask, enabled);
+    pthread_once(&stdin_once, iniciar_thread_stdin);
+}
+
+// ===================== PWM =====================
+void pwm_set_clkdiv(uint slice_num, float divider)
+{
+    (void)slice_num;
+    (void)divider;
+}
+
+void pwm_set_wrap(uint slice_num, uint16_t wrap)
+{
+    (void)slice_num;
+    (void)wrap;
+}
+
+void pwm_set_gpio_level(uint gpio, uint16_t level)
+{
+    (void)gpio;
+    (void)level;
+}
+
+void pwm_set_enabled(uint slice_num, bool enabled)
+{
+    (void)slice_num;
+    (void)enabled;
+}
+
+// ===================== BOOTROM =====================
+void reset_usb_boot(uint32_t usb_activity_gpio_pin_mask, uint32_t disable_interface_mask)
+{
+    (void)usb_activity_gpio_pin_mask;
+    (void)disable_interface_mask;
+    printf("[HOST] reset_usb_boot: encerrando a simulação.\n");
+    fflush(stdout);
+    exit(0);
+}
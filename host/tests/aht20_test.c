@@ -0,0 +1,149 @@
+/*
+ * Teste host das esperas do driver AHT20 (lib/aht20.c): toda espera de aht20_init,
+ * aht20_read e aht20_reset passa pela função instalada com aht20_set_delay, e a espera
+ * padrão nunca chama sleep_ms (espera ocupada no RP2040) com o escalonador rodando.
+ *
+ * O teste instala no barramento falso (i2c_falso.c) um AHT20 que fica ocupado por algumas
+ * leituras de status após o disparo e fornece sleep_ms e as funções do FreeRTOS usadas
+ * pelo driver, todas contando chamadas. Não liga pico_stub.c nem freertos_posix.c.
+ */
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "aht20.h"
+#include "i2c_falso.h"
+#include "teste.h"
+
+#define LEITURAS_OCUPADO 3 // Leituras de status com o bit de ocupado após cada disparo
+
+// ===================== AHT20 FALSO =====================
+static int ocupado; // Leituras de status que ainda respondem "medindo"
+
+// Amostra do datasheet: 0x1C71C = 1/9 de 2^20 de umidade e metade da escala de temperatura
+static const uint8_t amostra[AHT20_TAMANHO_RESPOSTA] = {0x18, 0x1C, 0x71, 0xC8, 0x00, 0x00};
+
+static int aht20_escrever(uint8_t addr, const uint8_t *src, size_t len)
+{
+    if (addr != AHT20_I2C_ADDR || len == 0)
+        return PICO_ERROR_GENERIC;
+    if (src[0] == AHT20_CMD_TRIGGER)
+        ocupado = LEITURAS_OCUPADO;
+    return (int)len;
+}
+
+static int aht20_ler(uint8_t addr, uint8_t *dst, size_t len)
+{
+    if (addr != AHT20_I2C_ADDR || len == 0)
+        return PICO_ERROR_GENERIC;
+    memset(dst, 0, len);
+    if (len == 1)
+    {
+        dst[0] = 0x08 | (ocupado > 0 ? 0x80 : 0); // Calibrado, ocupado enquanto mede
+        if (ocupado > 0)
+            ocupado--;
+        return 1;
+    }
+    memcpy(dst, amostra, len < sizeof(amostra) ? len : sizeof(amostra));
+    return (int)len;
+}
+
+// ===================== ESPERAS CONTADAS =====================
+static BaseType_t escalonador = taskSCHEDULER_RUNNING;
+static int chamadas_sleep_ms;
+static int chamadas_vtaskdelay;
+static int chamadas_gancho;
+static uint32_t ms_gancho;
+
+void sleep_ms(uint32_t ms)
+{
+    (void)ms;
+    chamadas_sleep_ms++;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    (void)ticks;
+    chamadas_vtaskdelay++;
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    return escalonador;
+}
+
+static void gancho(uint32_t ms)
+{
+    chamadas_gancho++;
+    ms_gancho += ms;
+}
+
+static void zerar_contadores(void)
+{
+    chamadas_sleep_ms = chamadas_vtaskdelay = chamadas_gancho = 0;
+    ms_gancho = 0;
+}
+
+// ===================== CASOS =====================
+static void teste_gancho(void)
+{
+    aht20_set_delay(gancho);
+    AHT20_Data dados;
+
+    zerar_contadores();
+    CONFERIR(aht20_init(i2c0));
+    CONFERIR(chamadas_gancho == 1 && ms_gancho == 50);
+
+    zerar_contadores();
+    CONFERIR(aht20_read(i2c0, &dados));
+    CONFERIR(chamadas_gancho == LEITURAS_OCUPADO && ms_gancho == LEITURAS_OCUPADO * 10u);
+    CONFERIR(dados.humidity == 1111 && dados.temperature == 5000);
+
+    zerar_contadores();
+    aht20_reset(i2c0);
+    CONFERIR(chamadas_gancho == 2 && ms_gancho == 20 + 50);
+
+    // Só o gancho espera: nem sleep_ms nem vTaskDelay por conta própria
+    CONFERIR(chamadas_sleep_ms == 0 && chamadas_vtaskdelay == 0);
+}
+
+static void teste_padrao_com_escalonador(void)
+{
+    aht20_set_delay(NULL);
+    escalonador = taskSCHEDULER_RUNNING;
+    AHT20_Data dados;
+
+    zerar_contadores();
+    CONFERIR(aht20_init(i2c0));
+    CONFERIR(aht20_read(i2c0, &dados));
+    aht20_reset(i2c0);
+    CONFERIR(chamadas_sleep_ms == 0);
+    CONFERIR(chamadas_vtaskdelay == 1 + LEITURAS_OCUPADO + 2);
+    CONFERIR(chamadas_gancho == 0);
+}
+
+static void teste_padrao_antes_do_escalonador(void)
+{
+    // Antes de vTaskStartScheduler não há vTaskDelay: sleep_ms é a única opção
+    aht20_set_delay(NULL);
+    escalonador = taskSCHEDULER_NOT_STARTED;
+
+    zerar_contadores();
+    CONFERIR(aht20_init(i2c0));
+    CONFERIR(chamadas_sleep_ms == 1 && chamadas_vtaskdelay == 0);
+    escalonador = taskSCHEDULER_RUNNING;
+}
+
+int main(void)
+{
+    i2c0_inst.escrever = aht20_escrever;
+    i2c0_inst.ler = aht20_ler;
+
+    teste_gancho();
+    teste_padrao_com_escalonador();
+    teste_padrao_antes_do_escalonador();
+
+    return teste_resultado("aht20_test");
+}
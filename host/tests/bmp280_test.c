@@ -0,0 +1,125 @@
+/*
+ * Teste host da compensação do BMP280 (lib/bmp280.c) com a calibração de exemplo do
+ * datasheet (seção 3.12): T 519888 e P 415148 dão 2508 (25,08 °C) e 100656 Pa.
+ *
+ * Os valores esperados de cada vetor saem da rotina de referência da Bosch em 32 bits
+ * (bmp280_compensate_T_int32/_P_int32), que o driver segue bit a bit; as fórmulas em
+ * ponto flutuante do datasheet (seção 8.1) conferem os mesmos vetores com tolerância.
+ * bmp280_compensate, bmp280_compensate_batch (com e sem sobreposição de raw e out) e
+ * o par convert_temp/convert_pressure devem concordar. Nenhuma delas usa o barramento,
+ * então i2c_falso.c fica sem dispositivo.
+ */
+
+#include <string.h>
+#include "bmp280.h"
+#include "teste.h"
+
+// ===================== VETORES =====================
+static struct bmp280_calib_param calib = {
+    .dig_t1 = 27504, .dig_t2 = 26435, .dig_t3 = -1000,
+    .dig_p1 = 36477, .dig_p2 = -10685, .dig_p3 = 3024, .dig_p4 = 2855, .dig_p5 = 140,
+    .dig_p6 = -7, .dig_p7 = 15500, .dig_p8 = -14600, .dig_p9 = 6000,
+};
+
+static const struct
+{
+    struct bmp280_reading bruta;
+    struct bmp280_reading esperada; // Centésimos de °C e Pa
+} vetores[] = {
+    {{519888, 415148}, {2508, 100656}}, // Exemplo do datasheet
+    {{400000, 300000}, {-1264, 113636}},
+    {{450000, 350000}, {313, 108162}},
+    {{480000, 380000}, {1257, 104685}},
+    {{550000, 500000}, {3451, 87273}},
+    {{600000, 450000}, {5011, 98272}},
+};
+
+#define TOTAL_VETORES (sizeof(vetores) / sizeof(vetores[0]))
+
+// Fórmulas em double do datasheet (seção 8.1): temperatura em °C e pressão em Pa
+static void referencia_double(int32_t adc_t, int32_t adc_p, double *temp, double *pressao)
+{
+    const struct bmp280_calib_param *c = &calib;
+    double var1 = ((double)adc_t / 16384.0 - (double)c->dig_t1 / 1024.0) * (double)c->dig_t2;
+    double var2 = ((double)adc_t / 131072.0 - (double)c->dig_t1 / 8192.0) *
+                  ((double)adc_t / 131072.0 - (double)c->dig_t1 / 8192.0) * (double)c->dig_t3;
+    double t_fine = var1 + var2;
+    *temp = t_fine / 5120.0;
+
+    var1 = t_fine / 2.0 - 64000.0;
+    var2 = var1 * var1 * (double)c->dig_p6 / 32768.0;
+    var2 = var2 + var1 * (double)c->dig_p5 * 2.0;
+    var2 = var2 / 4.0 + (double)c->dig_p4 * 65536.0;
+    var1 = ((double)c->dig_p3 * var1 * var1 / 524288.0 + (double)c->dig_p2 * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * (double)c->dig_p1;
+    double p = 1048576.0 - (double)adc_p;
+    p = (p - var2 / 4096.0) * 6250.0 / var1;
+    var1 = (double)c->dig_p9 * p * p / 2147483648.0;
+    var2 = p * (double)c->dig_p8 / 32768.0;
+    *pressao = p + (var1 + var2 + (double)c->dig_p7) / 16.0;
+}
+
+static bool confere(const struct bmp280_reading *obtida, size_t i)
+{
+    return obtida->temp == vetores[i].esperada.temp && obtida->pressure == vetores[i].esperada.pressure;
+}
+
+// ===================== CASOS =====================
+static void teste_referencia_double(void)
+{
+    // A versão em 32 bits arredonda a pressão por baixo em alguns Pa
+    for (size_t i = 0; i < TOTAL_VETORES; i++)
+    {
+        double temp, pressao;
+        referencia_double(vetores[i].bruta.temp, vetores[i].bruta.pressure, &temp, &pressao);
+        double dt = vetores[i].esperada.temp / 100.0 - temp;
+        double dp = vetores[i].esperada.pressure - pressao;
+        CONFERIR(dt > -0.01 && dt < 0.01);
+        CONFERIR(dp > -5.0 && dp < 5.0);
+    }
+}
+
+static void teste_compensate(void)
+{
+    for (size_t i = 0; i < TOTAL_VETORES; i++)
+    {
+        struct bmp280_reading out;
+        bmp280_compensate(&vetores[i].bruta, &out, &calib);
+        CONFERIR(confere(&out, i));
+
+        // API antiga: t_fine calculado duas vezes, mesmo resultado
+        CONFERIR(bmp280_convert_temp(vetores[i].bruta.temp, &calib) == vetores[i].esperada.temp);
+        CONFERIR(bmp280_convert_pressure(vetores[i].bruta.pressure, vetores[i].bruta.temp, &calib) ==
+                 vetores[i].esperada.pressure);
+    }
+}
+
+static void teste_batch(void)
+{
+    struct bmp280_reading raw[TOTAL_VETORES], out[TOTAL_VETORES];
+    for (size_t i = 0; i < TOTAL_VETORES; i++)
+        raw[i] = vetores[i].bruta;
+
+    bmp280_compensate_batch(raw, out, TOTAL_VETORES, &calib);
+    for (size_t i = 0; i < TOTAL_VETORES; i++)
+        CONFERIR(confere(&out[i], i));
+
+    // raw e out no mesmo vetor, como permite bmp280.h
+    bmp280_compensate_batch(raw, raw, TOTAL_VETORES, &calib);
+    for (size_t i = 0; i < TOTAL_VETORES; i++)
+        CONFERIR(confere(&raw[i], i));
+
+    // n = 0 não toca em nada
+    memset(out, 0x5A, sizeof(out));
+    bmp280_compensate_batch(raw, out, 0, &calib);
+    CONFERIR(out[0].temp == 0x5A5A5A5A && out[0].pressure == 0x5A5A5A5A);
+}
+
+int main(void)
+{
+    teste_referencia_double();
+    teste_compensate();
+    teste_batch();
+
+    return teste_resultado("bmp280_test");
+}
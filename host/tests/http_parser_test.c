@@ -0,0 +1,115 @@
+/*
+ * Teste host da negociação de conteúdo do parser HTTP (lib/http_parser.c): os tokens
+ * de Accept, Accept-Encoding, Connection e Upgrade são achados mesmo quando o valor
+ * passa de HTTP_MAX_VALOR_CAB, inclusive com a requisição chegando byte a byte.
+ */
+
+#include <string.h>
+#include "http_parser.h"
+#include "teste.h"
+
+// Valores de navegadores reais, todos maiores que HTTP_MAX_VALOR_CAB
+#define ACCEPT_NAVEGADOR "text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp," \
+                         "image/apng,*/*;q=0.8,application/signed-exchange;v=b3;q=0.7"
+#define ENCODING_LONGO "identity;q=0.1, deflate;q=0.5, br;q=0.9, zstd;q=0.8, compress;q=0.2, x-custom-encoding;q=0.3, gzip"
+
+// Consome a requisição em pedaços de tamanho passo; retorna o resultado final
+static http_parser_resultado_t analisar(http_parser_t *p, const char *req, size_t passo)
+{
+    http_parser_iniciar(p);
+    size_t len = strlen(req), pos = 0;
+    http_parser_resultado_t res = HTTP_PARSER_INCOMPLETO;
+    while (pos < len && res == HTTP_PARSER_INCOMPLETO)
+    {
+        size_t n = len - pos < passo ? len - pos : passo;
+        size_t consumidos;
+        res = http_parser_consumir(p, req + pos, n, &consumidos);
+        pos += consumidos;
+    }
+    return res;
+}
+
+static void teste_accept_longo(size_t passo)
+{
+    http_parser_t p;
+    _Static_assert(sizeof(ACCEPT_NAVEGADOR ",application/octet-stream") - 1 > HTTP_MAX_VALOR_CAB, "valor curto");
+    CONFERIR(analisar(&p, "GET /json HTTP/1.1\r\nAccept: " ACCEPT_NAVEGADOR ",application/octet-stream\r\n\r\n",
+                      passo) == HTTP_PARSER_COMPLETO);
+    CONFERIR(p.aceita_binario);
+
+    CONFERIR(analisar(&p, "GET /json HTTP/1.1\r\nAccept: " ACCEPT_NAVEGADOR "\r\n\r\n", passo) == HTTP_PARSER_COMPLETO);
+    CONFERIR(!p.aceita_binario);
+}
+
+static void teste_accept_encoding_longo(size_t passo)
+{
+    http_parser_t p;
+    _Static_assert(sizeof(ENCODING_LONGO) - 1 > HTTP_MAX_VALOR_CAB, "valor curto");
+    CONFERIR(analisar(&p, "GET / HTTP/1.1\r\nAccept-Encoding: " ENCODING_LONGO "\r\n\r\n", passo) == HTTP_PARSER_COMPLETO);
+    CONFERIR(p.aceita_gzip);
+
+    CONFERIR(analisar(&p, "GET / HTTP/1.1\r\nAccept-Encoding: " ENCODING_LONGO ";q=0\r\n\r\n", passo) == HTTP_PARSER_COMPLETO);
+    CONFERIR(!p.aceita_gzip);
+
+    CONFERIR(analisar(&p, "GET / HTTP/1.1\r\nAccept-Encoding: gzip;q=0.5, br\r\n\r\n", passo) == HTTP_PARSER_COMPLETO);
+    CONFERIR(p.aceita_gzip);
+}
+
+static void teste_peso_com_espacos(size_t passo)
+{
+    // RFC 9110: espaço opcional dos dois lados do ';' e "q" sem diferenciar maiúsculas
+    static const char *const recusas[] = {"gzip; q=0", "gzip ;q=0", "gzip\t;\tq=0.0", "br, gzip ; Q=0 , deflate"};
+    static const char *const aceites[] = {"gzip; q=0.5", "gzip ;q=1", "gzip ; level=1"};
+    http_parser_t p;
+    char req[128];
+    for (size_t i = 0; i < sizeof(recusas) / sizeof(recusas[0]); i++)
+    {
+        snprintf(req, sizeof(req), "GET / HTTP/1.1\r\nAccept-Encoding: %s\r\n\r\n", recusas[i]);
+        CONFERIR(analisar(&p, req, passo) == HTTP_PARSER_COMPLETO);
+        CONFERIR(!p.aceita_gzip);
+    }
+    for (size_t i = 0; i < sizeof(aceites) / sizeof(aceites[0]); i++)
+    {
+        snprintf(req, sizeof(req), "GET / HTTP/1.1\r\nAccept-Encoding: %s\r\n\r\n", aceites[i]);
+        CONFERIR(analisar(&p, req, passo) == HTTP_PARSER_COMPLETO);
+        CONFERIR(p.aceita_gzip);
+    }
+}
+
+static void teste_connection_upgrade(size_t passo)
+{
+    http_parser_t p;
+    CONFERIR(analisar(&p, "GET /ws HTTP/1.1\r\nConnection: keep-alive, Upgrade\r\nUpgrade: websocket\r\n"
+                          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n",
+                      passo) == HTTP_PARSER_COMPLETO);
+    CONFERIR(p.conexao_keep_alive && p.conexao_upgrade && !p.conexao_close);
+    CONFERIR(p.upgrade_websocket);
+    CONFERIR(strcmp(p.websocket_chave, "dGhlIHNhbXBsZSBub25jZQ==") == 0 && p.websocket_versao == 13);
+
+    CONFERIR(analisar(&p, "GET / HTTP/1.0\r\nConnection: close\r\n\r\n", passo) == HTTP_PARSER_COMPLETO);
+    CONFERIR(p.conexao_close && !http_parser_keep_alive(&p));
+}
+
+static void teste_corpo_apos_lista(size_t passo)
+{
+    // Content-Length depois de um cabeçalho-lista continua sendo lido inteiro
+    http_parser_t p;
+    CONFERIR(analisar(&p, "POST /cfg HTTP/1.1\r\nAccept: " ACCEPT_NAVEGADOR "\r\nContent-Length: 13\r\n\r\ntemp_min=16.5",
+                      passo) == HTTP_PARSER_COMPLETO);
+    CONFERIR(p.content_length == 13 && strcmp(p.corpo, "temp_min=16.5") == 0);
+}
+
+int main(void)
+{
+    static const size_t passos[] = {1, 7, 4096};
+    for (size_t i = 0; i < sizeof(passos) / sizeof(passos[0]); i++)
+    {
+        teste_accept_longo(passos[i]);
+        teste_accept_encoding_longo(passos[i]);
+        teste_peso_com_espacos(passos[i]);
+        teste_connection_upgrade(passos[i]);
+        teste_corpo_apos_lista(passos[i]);
+    }
+
+    return teste_resultado("http_parser_test");
+}
@@ -0,0 +1,18 @@
+// Barramento I2C dos testes host (ver i2c_falso.h)
+
+#include "i2c_falso.h"
+
+i2c_inst_t i2c0_inst;
+i2c_inst_t i2c1_inst;
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop)
+{
+    (void)nostop;
+    return i2c->escrever ? i2c->escrever(addr, src, len) : PICO_ERROR_GENERIC;
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop)
+{
+    (void)nostop;
+    return i2c->ler ? i2c->ler(addr, dst, len) : PICO_ERROR_GENERIC;
+}
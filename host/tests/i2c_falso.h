@@ -0,0 +1,19 @@
+#ifndef I2C_FALSO_H
+#define I2C_FALSO_H
+
+// Barramento I2C dos testes host, no lugar de host/i2c_sim.c: sem dispositivos nem
+// espera. Cada teste instala em i2c0_inst/i2c1_inst as funções do seu dispositivo
+// falso; sem função instalada a transação falha com PICO_ERROR_GENERIC.
+
+#include "hardware/i2c.h"
+
+typedef int (*i2c_falso_escrita_t)(uint8_t addr, const uint8_t *src, size_t len);
+typedef int (*i2c_falso_leitura_t)(uint8_t addr, uint8_t *dst, size_t len);
+
+struct i2c_inst
+{
+    i2c_falso_escrita_t escrever;
+    i2c_falso_leitura_t ler;
+};
+
+#endif // I2C_FALSO_H
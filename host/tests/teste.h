@@ -0,0 +1,35 @@
+#ifndef TESTE_H
+#define TESTE_H
+
+// Apoio comum aos testes host: CONFERIR registra a falha e segue para o próximo caso, e
+// teste_resultado imprime o resumo e devolve o código de saída conferido pelo ctest.
+// Cada teste é um único arquivo, então o contador pode ser static aqui.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int falhas;
+
+#define CONFERIR(cond)                                                  \
+    do                                                                  \
+    {                                                                   \
+        if (!(cond))                                                    \
+        {                                                               \
+            printf("[FALHA] %s:%d: %s\n", __FILE__, __LINE__, #cond);   \
+            falhas++;                                                   \
+        }                                                               \
+    } while (0)
+
+// Uso: return teste_resultado("nome_test");
+static inline int teste_resultado(const char *nome)
+{
+    if (falhas)
+    {
+        printf("%s: %d falha(s)\n", nome, falhas);
+        return EXIT_FAILURE;
+    }
+    printf("%s: ok\n", nome);
+    return EXIT_SUCCESS;
+}
+
+#endif // TESTE_H
@@ -69,8 +69,17 @@
  #define configMESSAGE_BUFFER_LENGTH_TYPE        size_t
  
  /* Memory allocation related definitions. */
+ /* 1 com a opção WEATHER_STATION_ESTATICO do CMake: tarefas, pilhas e event
+    group viram variáveis globais (contabilizadas no relatório de RAM do link) e o
+    heap do FreeRTOS sai do firmware, então nenhuma criação dinâmica chega a linkar */
+ #ifndef configSUPPORT_STATIC_ALLOCATION
  #define configSUPPORT_STATIC_ALLOCATION         0
+ #endif
+ #if configSUPPORT_STATIC_ALLOCATION
+ #define configSUPPORT_DYNAMIC_ALLOCATION        0
+ #else
  #define configSUPPORT_DYNAMIC_ALLOCATION        1
+ #endif
  #define configTOTAL_HEAP_SIZE                   (128*1024)
  #define configAPPLICATION_ALLOCATED_HEAP        0
  
@@ -80,7 +89,17 @@
  #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
  
  /* Run time and task stats gathering related definitions. */
- #define configGENERATE_RUN_TIME_STATS           0
+ /* Tempo de CPU por tarefa (GET /stats) medido pelo timer de 1 µs do RP2040, que roda
+    desde o boot; em 64 bits o contador não dá a volta. A saída em JSON é montada em
+    weather_station.c com uxTaskGetSystemState, sem as funções de formatação. */
+ #define configGENERATE_RUN_TIME_STATS           1
+ #define configRUN_TIME_COUNTER_TYPE             uint64_t
+ #ifndef __ASSEMBLER__
+ #include <stdint.h>
+ extern uint64_t time_us_64(void);
+ #endif
+ #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+ #define portGET_RUN_TIME_COUNTER_VALUE()        time_us_64()
  #define configUSE_TRACE_FACILITY                1
  #define configUSE_STATS_FORMATTING_FUNCTIONS    0
  
@@ -102,9 +121,18 @@
  */
  
  /* SMP port only */
+ /* 2 com a opção WEATHER_STATION_SMP do CMake; a afinidade de cada tarefa é
+    definida em weather_station.c (rede no núcleo 0, aplicação no núcleo 1) */
+ #ifndef configNUM_CORES
  #define configNUM_CORES                         1
+ #endif
+ #define configNUMBER_OF_CORES                   configNUM_CORES
  #define configTICK_CORE                         1
  #define configRUN_MULTIPLE_PRIORITIES           1
+ #if configNUM_CORES > 1
+ #define configUSE_CORE_AFFINITY                 1
+ #define configUSE_PASSIVE_IDLE_HOOK             0
+ #endif
  
  /* RP2040 specific */
  #define configSUPPORT_PICO_SYNC_INTEROP         1
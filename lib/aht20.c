@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "FreeRTOS.h"
+#include "task.h"
 #include "aht20.h"
 
 #define AHT20_I2C_ADDR      0x38
@@ -10,10 +12,23 @@
 #define AHT20_STATUS_BUSY   0x80  // Bit de status ocupado
 #define AHT20_STATUS_CALIBRATED 0x08  // Bit de calibração
 
+static void delay_padrao(uint32_t ms) {
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+        vTaskDelay(pdMS_TO_TICKS(ms));
+    else
+        sleep_ms(ms);
+}
+
+static aht20_delay_fn_t delay = delay_padrao;
+
+void aht20_set_delay(aht20_delay_fn_t fn) {
+    delay = fn ? fn : delay_padrao;
+}
+
 bool aht20_init(i2c_inst_t *i2c) {
     uint8_t init_cmd[3] = {AHT20_CMD_INIT, 0x08, 0x00};
     i2c_write_blocking(i2c, AHT20_I2C_ADDR, init_cmd, 3, false);
-    sleep_ms(50);  // Aguarda o sensor inicializar
+    delay(50);  // Aguarda o sensor inicializar
 
     // Verifica status até que o sensor esteja pronto
     uint8_t status;
@@ -22,18 +37,37 @@ bool aht20_init(i2c_inst_t *i2c) {
         if ((status & AHT20_STATUS_CALIBRATED) == AHT20_STATUS_CALIBRATED) {
             return true;  // Sensor calibrado e pronto
         }
-        sleep_ms(10);
+        delay(10);
     }
 
     return false;  // Falhou na calibração
 }
 
+const uint8_t aht20_cmd_trigger[3] = {AHT20_CMD_TRIGGER, 0x33, 0x00};
+
+bool aht20_parse(const uint8_t buffer[AHT20_TAMANHO_RESPOSTA], AHT20_Data *data) {
+    if (buffer[0] & AHT20_STATUS_BUSY) {
+        return false;
+    }
+
+    // Processa os dados de umidade (20 bits): RH = raw * 100% / 2^20. Em centésimos,
+    // raw * 10000 / 2^20 = raw * 625 / 2^16, que cabe em 32 bits (raw < 2^20)
+    uint32_t raw_humidity = ((uint32_t)buffer[1] << 12) | ((uint32_t)buffer[2] << 4) | (buffer[3] >> 4);
+    data->humidity = (int32_t)((raw_humidity * 625u + 0x8000u) >> 16);
+
+    // Processa os dados de temperatura (20 bits): T = raw * 200 / 2^20 - 50 °C, ou seja,
+    // raw * 1250 / 2^16 - 5000 centésimos
+    uint32_t raw_temp = ((uint32_t)(buffer[3] & 0x0F) << 16) | ((uint32_t)buffer[4] << 8) | buffer[5];
+    data->temperature = (int32_t)((raw_temp * 1250u + 0x8000u) >> 16) - 5000;
+
+    return true;
+}
+
 bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
-    uint8_t trigger_cmd[3] = {AHT20_CMD_TRIGGER, 0x33, 0x00};
-    uint8_t buffer[6];
+    uint8_t buffer[AHT20_TAMANHO_RESPOSTA];
 
     // Envia comando de medição
-    i2c_write_blocking(i2c, AHT20_I2C_ADDR, trigger_cmd, 3, false);
+    i2c_write_blocking(i2c, AHT20_I2C_ADDR, aht20_cmd_trigger, 3, false);
     
     // Aguarda até o sensor estar pronto
     uint8_t status;
@@ -42,7 +76,7 @@ bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
         if (!(status & AHT20_STATUS_BUSY)) {
             break;
         }
-        sleep_ms(10);
+        delay(10);
     }
     
     // Se ainda estiver ocupado, falha na leitura
@@ -51,25 +85,17 @@ bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
     }
 
     // Lê os 6 bytes de dados
-    if (i2c_read_blocking(i2c, AHT20_I2C_ADDR, buffer, 6, false) != 6) {
+    if (i2c_read_blocking(i2c, AHT20_I2C_ADDR, buffer, AHT20_TAMANHO_RESPOSTA, false) != AHT20_TAMANHO_RESPOSTA) {
         return false;
     }
 
-    // Processa os dados de umidade (20 bits)
-    uint32_t raw_humidity = ((uint32_t)buffer[1] << 12) | ((uint32_t)buffer[2] << 4) | (buffer[3] >> 4);
-    data->humidity = (float)raw_humidity * 100.0 / 1048576.0;
-
-    // Processa os dados de temperatura (20 bits)
-    uint32_t raw_temp = ((uint32_t)(buffer[3] & 0x0F) << 16) | ((uint32_t)buffer[4] << 8) | buffer[5];
-    data->temperature = ((float)raw_temp * 200.0 / 1048576.0) - 50.0;
-
-    return true;
+    return aht20_parse(buffer, data);
 }
 
 void aht20_reset(i2c_inst_t *i2c) {
     uint8_t reset_cmd = AHT20_CMD_RESET;
     i2c_write_blocking(i2c, AHT20_I2C_ADDR, &reset_cmd, 1, false);
-    sleep_ms(20);
+    delay(20);
     aht20_init(i2c);
 }
 
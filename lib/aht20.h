@@ -10,18 +10,36 @@
 #define AHT20_CMD_TRIGGER   0xAC
 #define AHT20_CMD_RESET     0xBA
 
-// Estrutura para armazenar os valores de temperatura e umidade
+// Tempo de conversão de uma medição (datasheet)
+#define AHT20_TEMPO_CONVERSAO_MS 80
+#define AHT20_TAMANHO_RESPOSTA   6
+
+// Estrutura para armazenar os valores de temperatura e umidade, em centésimos
+// (2345 = 23,45 °C ou 23,45 %), calculados só com aritmética inteira
 typedef struct {
-    float temperature;
-    float humidity;
+    int32_t temperature;
+    int32_t humidity;
 } AHT20_Data;
 
+// Espera usada pelo driver entre comandos. O padrão é vTaskDelay com o escalonador do
+// FreeRTOS rodando (a CPU fica livre para as outras tarefas) e sleep_ms antes dele.
+typedef void (*aht20_delay_fn_t)(uint32_t ms);
+
+// Troca a espera do driver (ex.: por um yield próprio); NULL restaura o padrão
+void aht20_set_delay(aht20_delay_fn_t delay);
+
 // Inicializa o sensor AHT20
 bool aht20_init(i2c_inst_t *i2c);
 
 // Faz a leitura de temperatura e umidade do AHT20
 bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data);
 
+// Leitura em duas fases, para quem controla a espera (ex.: fila i2c_dma): escreva
+// aht20_cmd_trigger, aguarde AHT20_TEMPO_CONVERSAO_MS, leia AHT20_TAMANHO_RESPOSTA
+// bytes e converta com aht20_parse. Retorna false se o sensor ainda está medindo.
+extern const uint8_t aht20_cmd_trigger[3];
+bool aht20_parse(const uint8_t buffer[AHT20_TAMANHO_RESPOSTA], AHT20_Data *data);
+
 // Reseta o sensor AHT20
 void aht20_reset(i2c_inst_t *i2c);
 
@@ -3,19 +3,63 @@
 
 #define ADDR _u(0x77)
 
+#define MODO_REPOUSO 0x00
+#define MODO_FORCADO 0x01
+
+// Códigos de osrs_t/osrs_p (1 = x1 ... 5 = x16) e do filtro (0 = desligado ... 4 = 16)
+static const struct {
+    uint8_t osrs_t, osrs_p, filtro;
+    const char *nome;
+} perfis[BMP280_PROFILE_COUNT] = {
+    [BMP280_PROFILE_ULTRA_LOW_POWER] = {1, 1, 0, "economico"},
+    [BMP280_PROFILE_STANDARD] = {1, 3, 2, "padrao"},
+    [BMP280_PROFILE_HIGH_RES] = {2, 5, 4, "alta_resolucao"},
+};
+
+static bmp280_profile_t perfil_valido(bmp280_profile_t profile) {
+    return (unsigned)profile < BMP280_PROFILE_COUNT ? profile : BMP280_PROFILE_STANDARD;
+}
+
 void bmp280_init(i2c_inst_t *i2c) {
+    // Modo forçado: nada de conversões contínuas entre as leituras
+    bmp280_set_profile(i2c, BMP280_PROFILE_STANDARD);
+}
+
+uint8_t bmp280_profile_config(bmp280_profile_t profile) {
+    // t_sb (bits 7:5) só vale no modo normal
+    return (uint8_t)(perfis[perfil_valido(profile)].filtro << 2);
+}
+
+static uint8_t ctrl_meas(bmp280_profile_t profile, uint8_t modo) {
+    profile = perfil_valido(profile);
+    return (uint8_t)((perfis[profile].osrs_t << 5) | (perfis[profile].osrs_p << 2) | modo);
+}
+
+uint8_t bmp280_profile_ctrl_meas(bmp280_profile_t profile) {
+    return ctrl_meas(profile, MODO_FORCADO);
+}
+
+uint32_t bmp280_profile_max_time_us(bmp280_profile_t profile) {
+    profile = perfil_valido(profile);
+    uint32_t t = 1u << (perfis[profile].osrs_t - 1);
+    uint32_t p = 1u << (perfis[profile].osrs_p - 1);
+    return 1250u + 2300u * t + 2300u * p + 575u;
+}
+
+const char *bmp280_profile_name(bmp280_profile_t profile) {
+    return perfis[perfil_valido(profile)].nome;
+}
+
+void bmp280_set_profile(i2c_inst_t *i2c, bmp280_profile_t profile) {
     uint8_t buf[2];
-    const uint8_t reg_config_val = ((0x04 << 5) | (0x05 << 2)) & 0xFC;
-    buf[0] = REG_CONFIG;
-    buf[1] = reg_config_val;
-   
-    i2c_write_blocking(i2c, ADDR, buf, 2, false);
-    
-    const uint8_t reg_ctrl_meas_val = (0x01 << 5) | (0x03 << 2) | (0x03);
+    // Primeiro o repouso: em outros modos a escrita de REG_CONFIG pode ser ignorada
     buf[0] = REG_CTRL_MEAS;
-    buf[1] = reg_ctrl_meas_val;
+    buf[1] = ctrl_meas(profile, MODO_REPOUSO);
+    i2c_write_blocking(i2c, ADDR, buf, 2, false);
+
+    buf[0] = REG_CONFIG;
+    buf[1] = bmp280_profile_config(profile);
     i2c_write_blocking(i2c, ADDR, buf, 2, false);
- //   printf("Ctrl_meas register value: %x\n", reg_ctrl_meas_val);
 }
 
 void bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure) {
@@ -23,11 +67,12 @@ void bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure) {
     uint8_t reg = REG_PRESSURE_MSB;
     i2c_write_blocking(i2c, ADDR, &reg, 1, true);
     i2c_read_blocking(i2c, ADDR, buf, 6, false);
+    bmp280_parse_raw(buf, temp, pressure);
+}
 
+void bmp280_parse_raw(const uint8_t buf[6], int32_t *temp, int32_t *pressure) {
     *pressure = (buf[0] << 12) | (buf[1] << 4) | (buf[2] >> 4);
     *temp = (buf[3] << 12) | (buf[4] << 4) | (buf[5] >> 4);
-
-
 }
 
 void bmp280_reset(i2c_inst_t *i2c) {
@@ -52,11 +97,8 @@ int32_t bmp280_convert_temp(int32_t temp, struct bmp280_calib_param* params) {
 }
 
 
-int32_t bmp280_convert_pressure(int32_t pressure, int32_t temp, struct bmp280_calib_param* params) {
-    // Utiliza os parâmetros de calibração do BMP280 para compensar o valor de pressão lido de seus registradores
-
-    int32_t t_fine = bmp280_convert(temp, params);
-
+// Compensação de pressão do datasheet (32 bits) a partir de um t_fine já calculado
+static uint32_t compensar_pressao(int32_t pressure, int32_t t_fine, struct bmp280_calib_param* params) {
     int32_t var1, var2;
     uint32_t converted = 0.0;
     var1 = (((int32_t)t_fine) >> 1) - (int32_t)64000;
@@ -80,6 +122,24 @@ int32_t bmp280_convert_pressure(int32_t pressure, int32_t temp, struct bmp280_ca
     return converted;
 }
 
+int32_t bmp280_convert_pressure(int32_t pressure, int32_t temp, struct bmp280_calib_param* params) {
+    // Utiliza os parâmetros de calibração do BMP280 para compensar o valor de pressão lido de seus registradores
+    return compensar_pressao(pressure, bmp280_convert(temp, params), params);
+}
+
+void bmp280_compensate(const struct bmp280_reading* raw, struct bmp280_reading* out, struct bmp280_calib_param* params) {
+    // t_fine calculado uma vez e usado pelas duas compensações
+    int32_t t_fine = bmp280_convert(raw->temp, params);
+    out->temp = (t_fine * 5 + 128) >> 8;
+    out->pressure = compensar_pressao(raw->pressure, t_fine, params);
+}
+
+void bmp280_compensate_batch(const struct bmp280_reading* raw, struct bmp280_reading* out, size_t n,
+                             struct bmp280_calib_param* params) {
+    for (size_t i = 0; i < n; i++)
+        bmp280_compensate(&raw[i], &out[i], params);
+}
+
 void bmp280_get_calib_params(i2c_inst_t *i2c, struct bmp280_calib_param* params) {
     uint8_t buf[NUM_CALIB_PARAMS] = { 0 };
     uint8_t reg = REG_DIG_T1_LSB;
@@ -5,11 +5,15 @@
 
 // Defina os endereços e registros conforme o código original
 #define ADDR _u(0x77)
+#define BMP280_I2C_ADDR ADDR
 
 #define REG_CONFIG _u(0xF5)
 #define REG_CTRL_MEAS _u(0xF4)
+#define REG_STATUS _u(0xF3)
 #define REG_RESET _u(0xE0)
 
+#define BMP280_STATUS_MEASURING 0x08  // Conversão em andamento
+
 #define REG_TEMP_XLSB _u(0xFC)
 #define REG_TEMP_LSB _u(0xFB)
 #define REG_TEMP_MSB _u(0xFA)
@@ -62,12 +66,53 @@ struct bmp280_calib_param
     int16_t dig_p9;
 };
 
+// Amostra bruta (registradores) ou compensada: temp em centésimos de °C, pressure em Pa
+struct bmp280_reading
+{
+    int32_t temp;
+    int32_t pressure;
+};
+
+// Perfis de medição em modo forçado (datasheet, seção 3.8): o sensor dorme entre
+// as leituras e cada escrita de REG_CTRL_MEAS dispara uma única conversão
+typedef enum
+{
+    BMP280_PROFILE_ULTRA_LOW_POWER,  // T x1, P x1, sem filtro IIR
+    BMP280_PROFILE_STANDARD,         // T x1, P x4, IIR coeficiente 4
+    BMP280_PROFILE_HIGH_RES,         // T x2, P x16, IIR coeficiente 16
+    BMP280_PROFILE_COUNT
+} bmp280_profile_t;
+
+// Tamanho da leitura em rajada a partir de REG_STATUS: status, ctrl_meas, config,
+// um registrador reservado e os 6 bytes de dados (formato de bmp280_parse_raw)
+#define BMP280_BURST_LEN 10
+#define BMP280_BURST_DATA 4
+
 // void bmp280_init(void);
 void bmp280_init(i2c_inst_t *i2c);
 void bmp280_read_raw(i2c_inst_t *i2c, int32_t *temp, int32_t *pressure);
+// Converte os 6 bytes lidos a partir de REG_PRESSURE_MSB (ex.: por uma fila i2c_dma)
+void bmp280_parse_raw(const uint8_t buf[6], int32_t *temp, int32_t *pressure);
 void bmp280_reset(i2c_inst_t *i2c);
+
+// Grava o filtro e a sobreamostragem do perfil deixando o sensor em repouso (bloqueante)
+void bmp280_set_profile(i2c_inst_t *i2c, bmp280_profile_t profile);
+// Valores de registrador do perfil, para quem controla o barramento (ex.: fila i2c_dma):
+// REG_CONFIG só é aceito com o sensor em repouso; REG_CTRL_MEAS já inclui o modo forçado
+uint8_t bmp280_profile_config(bmp280_profile_t profile);
+uint8_t bmp280_profile_ctrl_meas(bmp280_profile_t profile);
+// Duração máxima de uma conversão do perfil (datasheet, seção 3.8.1)
+uint32_t bmp280_profile_max_time_us(bmp280_profile_t profile);
+const char *bmp280_profile_name(bmp280_profile_t profile);
 int32_t bmp280_convert_temp(int32_t temp, struct bmp280_calib_param *params);
 int32_t bmp280_convert_pressure(int32_t pressure, int32_t temp, struct bmp280_calib_param *params);
 void bmp280_get_calib_params(i2c_inst_t *i2c, struct bmp280_calib_param *params);
 
+// Temperatura e pressão compensadas de uma amostra bruta, com um único cálculo de t_fine
+// (convert_temp + convert_pressure calculam t_fine duas vezes)
+void bmp280_compensate(const struct bmp280_reading *raw, struct bmp280_reading *out, struct bmp280_calib_param *params);
+// O mesmo para n amostras (ex.: uma rajada); raw e out podem ser o mesmo vetor
+void bmp280_compensate_batch(const struct bmp280_reading *raw, struct bmp280_reading *out, size_t n,
+                             struct bmp280_calib_param *params);
+
 #endif
@@ -0,0 +1,363 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "http_parser.h"
+
+enum {
+    ESTADO_METODO,
+    ESTADO_CAMINHO,
+    ESTADO_QUERY,
+    ESTADO_VERSAO,
+    ESTADO_NOME,
+    ESTADO_VALOR,
+    ESTADO_CORPO,
+    ESTADO_COMPLETO,
+    ESTADO_ERRO
+};
+
+static const struct {
+    const char *nome;
+    http_metodo_t metodo;
+} metodos[] = {
+    {"GET", HTTP_METODO_GET},
+    {"HEAD", HTTP_METODO_HEAD},
+    {"POST", HTTP_METODO_POST},
+    {"PUT", HTTP_METODO_PUT},
+    {"DELETE", HTTP_METODO_DELETE},
+    {"OPTIONS", HTTP_METODO_OPTIONS},
+};
+
+void http_parser_iniciar(http_parser_t *p) {
+    // Só os campos de controle: os buffers são sobrescritos conforme os bytes chegam
+    p->estado = ESTADO_METODO;
+    p->erro = 0;
+    p->metodo = HTTP_METODO_DESCONHECIDO;
+    p->metodo_len = 0;
+    p->caminho_len = 0;
+    p->caminho[0] = '\0';
+    p->query_len = 0;
+    p->query[0] = '\0';
+    p->versao_len = 0;
+    p->http10 = false;
+    p->nome_len = 0;
+    p->valor_len = 0;
+    p->valor_lista = false;
+    p->cabecalhos_len = 0;
+    p->tem_content_length = false;
+    p->content_length = 0;
+    p->aceita_gzip = false;
+    p->aceita_binario = false;
+    p->conexao_close = false;
+    p->conexao_keep_alive = false;
+    p->conexao_upgrade = false;
+    p->upgrade_websocket = false;
+    p->websocket_chave[0] = '\0';
+    p->websocket_versao = 0;
+    p->corpo_len = 0;
+    p->corpo[0] = '\0';
+}
+
+static http_parser_resultado_t falhar(http_parser_t *p, uint16_t status) {
+    p->estado = ESTADO_ERRO;
+    p->erro = status;
+    return HTTP_PARSER_ERRO;
+}
+
+// Procura token (sem diferenciar maiúsculas) numa lista separada por vírgulas
+static const char *buscar_token(const char *lista, const char *token) {
+    size_t n = strlen(token);
+    for (const char *t = lista; *t; ) {
+        while (*t == ' ' || *t == '\t' || *t == ',')
+            t++;
+        if (strncasecmp(t, token, n) == 0 && (t[n] == '\0' || t[n] == ',' || t[n] == ';' || t[n] == ' ' || t[n] == '\t'))
+            return t;
+        t = strchr(t, ',');
+        if (!t)
+            break;
+    }
+    return NULL;
+}
+
+// gzip aceito se listado sem q=0 (ou 0.0, 0.00...); RFC 9110 permite espaço dos dois lados do ';'
+static bool valor_aceita_gzip(const char *valor) {
+    const char *t = buscar_token(valor, "gzip");
+    if (!t)
+        return false;
+    t += 4;
+    t += strspn(t, " \t");
+    if (*t != ';')
+        return true;
+    t++;
+    t += strspn(t, " \t");
+    if (strncasecmp(t, "q=", 2) != 0)
+        return true;
+    t += 2;
+    return strspn(t, "0.") < strcspn(t, ", \t");
+}
+
+static void terminar_valor(http_parser_t *p) {
+    while (p->valor_len > 0 && (p->valor[p->valor_len - 1] == ' ' || p->valor[p->valor_len - 1] == '\t'))
+        p->valor_len--;
+    p->valor[p->valor_len] = '\0';
+}
+
+// Cabeçalhos-lista cujos elementos o servidor procura. Um navegador manda Accept e
+// Accept-Encoding maiores que HTTP_MAX_VALOR_CAB; avaliados um elemento por vez, o
+// token procurado é achado mesmo no fim da lista e só os flags ficam guardados.
+static bool cabecalho_lista(const char *nome) {
+    return strcmp(nome, "connection") == 0 || strcmp(nome, "upgrade") == 0 ||
+           strcmp(nome, "accept") == 0 || strcmp(nome, "accept-encoding") == 0;
+}
+
+static void avaliar_elemento(http_parser_t *p) {
+    terminar_valor(p);
+    if (strcmp(p->nome, "connection") == 0) {
+        if (buscar_token(p->valor, "close"))
+            p->conexao_close = true;
+        if (buscar_token(p->valor, "keep-alive"))
+            p->conexao_keep_alive = true;
+        if (buscar_token(p->valor, "upgrade"))
+            p->conexao_upgrade = true;
+    } else if (strcmp(p->nome, "upgrade") == 0) {
+        if (buscar_token(p->valor, "websocket"))
+            p->upgrade_websocket = true;
+    } else if (strcmp(p->nome, "accept-encoding") == 0) {
+        if (valor_aceita_gzip(p->valor))
+            p->aceita_gzip = true;
+    } else if (strcmp(p->nome, "accept") == 0) {
+        if (buscar_token(p->valor, "application/octet-stream"))
+            p->aceita_binario = true;
+    }
+    p->valor_len = 0;
+}
+
+static http_parser_resultado_t finalizar_cabecalho(http_parser_t *p) {
+    p->nome[p->nome_len] = '\0';
+    if (p->valor_lista) {
+        avaliar_elemento(p);
+        p->nome_len = 0;
+        return HTTP_PARSER_INCOMPLETO;
+    }
+    terminar_valor(p);
+
+    if (strcmp(p->nome, "content-length") == 0) {
+        if (p->valor_len == 0 || strspn(p->valor, "0123456789") != p->valor_len || p->valor_len > 9)
+            return falhar(p, 400);
+        uint32_t len = 0;
+        for (uint8_t i = 0; i < p->valor_len; i++)
+            len = len * 10 + (uint32_t)(p->valor[i] - '0');
+        if (p->tem_content_length && len != p->content_length)
+            return falhar(p, 400);
+        if (len > HTTP_MAX_CORPO)
+            return falhar(p, 413);
+        p->tem_content_length = true;
+        p->content_length = len;
+    } else if (strcmp(p->nome, "transfer-encoding") == 0) {
+        // Corpo em chunks não é suportado
+        return falhar(p, 501);
+    } else if (strcmp(p->nome, "sec-websocket-key") == 0) {
+        if (p->valor_len == sizeof(p->websocket_chave) - 1)
+            memcpy(p->websocket_chave, p->valor, sizeof(p->websocket_chave));
+    } else if (strcmp(p->nome, "sec-websocket-version") == 0) {
+        p->websocket_versao = (uint8_t)atoi(p->valor);
+    }
+
+    p->nome_len = 0;
+    p->valor_len = 0;
+    return HTTP_PARSER_INCOMPLETO;
+}
+
+static void finalizar_metodo(http_parser_t *p) {
+    p->metodo_txt[p->metodo_len] = '\0';
+    for (size_t i = 0; i < sizeof(metodos) / sizeof(metodos[0]); i++) {
+        if (strcmp(p->metodo_txt, metodos[i].nome) == 0) {
+            p->metodo = metodos[i].metodo;
+            break;
+        }
+    }
+}
+
+static http_parser_resultado_t finalizar_versao(http_parser_t *p) {
+    p->versao[p->versao_len] = '\0';
+    if (strcmp(p->versao, "HTTP/1.1") == 0)
+        p->http10 = false;
+    else if (strcmp(p->versao, "HTTP/1.0") == 0)
+        p->http10 = true;
+    else if (strncmp(p->versao, "HTTP/", 5) == 0)
+        return falhar(p, 505);
+    else
+        return falhar(p, 400);
+    if (p->caminho_len == 0 || p->caminho[0] != '/')
+        return falhar(p, 400);
+    return HTTP_PARSER_INCOMPLETO;
+}
+
+http_parser_resultado_t http_parser_consumir(http_parser_t *p, const char *dados, size_t len, size_t *consumidos) {
+    size_t i = 0;
+    http_parser_resultado_t res = HTTP_PARSER_INCOMPLETO;
+
+    if (p->estado == ESTADO_COMPLETO || p->estado == ESTADO_ERRO) {
+        *consumidos = 0;
+        return p->estado == ESTADO_COMPLETO ? HTTP_PARSER_COMPLETO : HTTP_PARSER_ERRO;
+    }
+
+    while (i < len && res == HTTP_PARSER_INCOMPLETO) {
+        if (p->estado == ESTADO_CORPO) {
+            // Corpo copiado em blocos: pode chegar dividido em vários segmentos
+            size_t n = p->content_length - p->corpo_len;
+            if (n > len - i)
+                n = len - i;
+            memcpy(p->corpo + p->corpo_len, dados + i, n);
+            p->corpo_len += (uint16_t)n;
+            i += n;
+            if (p->corpo_len == p->content_length) {
+                p->corpo[p->corpo_len] = '\0';
+                p->estado = ESTADO_COMPLETO;
+                res = HTTP_PARSER_COMPLETO;
+            }
+            break;
+        }
+
+        char c = dados[i++];
+        if (++p->cabecalhos_len > HTTP_MAX_CABECALHOS) {
+            res = falhar(p, 431);
+            break;
+        }
+
+        switch (p->estado) {
+        case ESTADO_METODO:
+            if (c == ' ' && p->metodo_len > 0) {
+                finalizar_metodo(p);
+                p->estado = ESTADO_CAMINHO;
+            } else if ((c == '\r' || c == '\n') && p->metodo_len == 0) {
+                p->cabecalhos_len--;  // Linhas vazias antes da requisição são ignoradas
+            } else if (c >= 'A' && c <= 'Z' && p->metodo_len < sizeof(p->metodo_txt) - 1) {
+                p->metodo_txt[p->metodo_len++] = c;
+            } else {
+                res = falhar(p, 400);
+            }
+            break;
+
+        case ESTADO_CAMINHO:
+        case ESTADO_QUERY:
+            if (c == ' ') {
+                p->caminho[p->caminho_len] = '\0';
+                p->query[p->query_len] = '\0';
+                p->estado = ESTADO_VERSAO;
+            } else if (c == '?' && p->estado == ESTADO_CAMINHO) {
+                p->estado = ESTADO_QUERY;
+            } else if ((unsigned char)c <= ' ' || c == 0x7F) {
+                res = falhar(p, 400);
+            } else if (p->estado == ESTADO_CAMINHO) {
+                if (p->caminho_len >= HTTP_MAX_CAMINHO)
+                    res = falhar(p, 414);
+                else
+                    p->caminho[p->caminho_len++] = c;
+            } else {
+                if (p->query_len >= HTTP_MAX_QUERY)
+                    res = falhar(p, 414);
+                else
+                    p->query[p->query_len++] = c;
+            }
+            break;
+
+        case ESTADO_VERSAO:
+            if (c == '\n') {
+                p->estado = ESTADO_NOME;
+                res = finalizar_versao(p);
+            } else if (c != '\r') {
+                if (p->versao_len >= sizeof(p->versao) - 1)
+                    res = falhar(p, 400);
+                else
+                    p->versao[p->versao_len++] = c;
+            }
+            break;
+
+        case ESTADO_NOME:
+            if (c == '\n') {
+                if (p->nome_len > 0) {
+                    res = falhar(p, 400);
+                } else if (p->content_length > 0) {
+                    p->estado = ESTADO_CORPO;
+                } else {
+                    p->estado = ESTADO_COMPLETO;
+                    res = HTTP_PARSER_COMPLETO;
+                }
+            } else if (c == ':') {
+                p->nome[p->nome_len] = '\0';
+                p->valor_lista = cabecalho_lista(p->nome);
+                p->estado = ESTADO_VALOR;
+            } else if (c != '\r') {
+                // Nomes longos demais nunca coincidem com os conhecidos: basta truncar
+                if (p->nome_len < HTTP_MAX_NOME_CAB)
+                    p->nome[p->nome_len++] = (char)tolower((unsigned char)c);
+            }
+            break;
+
+        case ESTADO_VALOR:
+            if (c == '\n') {
+                p->estado = ESTADO_NOME;
+                res = finalizar_cabecalho(p);
+            } else if (c == '\r' || ((c == ' ' || c == '\t') && p->valor_len == 0)) {
+                // Espaços iniciais e o CR do fim da linha não fazem parte do valor
+            } else if (c == ',' && p->valor_lista) {
+                avaliar_elemento(p);
+            } else if (p->valor_len < HTTP_MAX_VALOR_CAB) {
+                p->valor[p->valor_len++] = c;
+            }
+            break;
+        }
+    }
+
+    *consumidos = i;
+    return res;
+}
+
+bool http_parser_keep_alive(const http_parser_t *p) {
+    if (p->conexao_close)
+        return false;
+    if (p->http10)
+        return p->conexao_keep_alive;
+    return true;
+}
+
+bool http_query_valor(const char *query, const char *chave, char *valor, size_t len) {
+    size_t n = strlen(chave);
+    const char *q = query;
+    while (q && *q) {
+        if (strncmp(q, chave, n) == 0 && q[n] == '=') {
+            q += n + 1;
+            size_t v = strcspn(q, "&");
+            if (v >= len)
+                v = len - 1;
+            memcpy(valor, q, v);
+            valor[v] = '\0';
+            return true;
+        }
+        q = strchr(q, '&');
+        if (q)
+            q++;
+    }
+    return false;
+}
+
+const char *http_status_texto(uint16_t status) {
+    switch (status) {
+    case 101: return "101 Switching Protocols";
+    case 200: return "200 OK";
+    case 400: return "400 Bad Request";
+    case 404: return "404 Not Found";
+    case 405: return "405 Method Not Allowed";
+    case 406: return "406 Not Acceptable";
+    case 413: return "413 Payload Too Large";
+    case 414: return "414 URI Too Long";
+    case 426: return "426 Upgrade Required";
+    case 431: return "431 Request Header Fields Too Large";
+    case 500: return "500 Internal Server Error";
+    case 501: return "501 Not Implemented";
+    case 503: return "503 Service Unavailable";
+    case 505: return "505 HTTP Version Not Supported";
+    default:  return "500 Internal Server Error";
+    }
+}
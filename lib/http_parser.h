@@ -0,0 +1,93 @@
+#ifndef HTTP_PARSER_H
+#define HTTP_PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Parser incremental de requisições HTTP/1.x. Consome os bytes na ordem em que
+// chegam (um pbuf por vez, sem copiar a requisição inteira) e guarda só o que o
+// servidor usa: método, caminho, query, cabeçalhos conhecidos e o corpo.
+
+// Limites dos campos armazenados (sem alocação dinâmica)
+#define HTTP_MAX_CAMINHO    64
+#define HTTP_MAX_QUERY      64
+#define HTTP_MAX_NOME_CAB   32    // Nomes maiores são ignorados
+#define HTTP_MAX_VALOR_CAB  96    // Valores maiores são truncados; nas listas, cada elemento
+#define HTTP_MAX_CABECALHOS 2048  // Total da linha de requisição + cabeçalhos
+#define HTTP_MAX_CORPO      512
+
+typedef enum {
+    HTTP_METODO_DESCONHECIDO = 0,
+    HTTP_METODO_GET,
+    HTTP_METODO_HEAD,
+    HTTP_METODO_POST,
+    HTTP_METODO_PUT,
+    HTTP_METODO_DELETE,
+    HTTP_METODO_OPTIONS
+} http_metodo_t;
+
+typedef enum {
+    HTTP_PARSER_INCOMPLETO,  // Precisa de mais bytes
+    HTTP_PARSER_COMPLETO,    // Requisição inteira disponível nos campos do parser
+    HTTP_PARSER_ERRO         // Requisição inválida; ver http_parser_t.erro
+} http_parser_resultado_t;
+
+typedef struct {
+    uint8_t estado;
+    uint16_t erro;                       // Status HTTP a responder quando HTTP_PARSER_ERRO
+
+    http_metodo_t metodo;
+    char metodo_txt[8];
+    uint8_t metodo_len;
+    char caminho[HTTP_MAX_CAMINHO + 1];
+    uint8_t caminho_len;
+    char query[HTTP_MAX_QUERY + 1];      // Parte após '?', sem o '?'
+    uint8_t query_len;
+    char versao[9];
+    uint8_t versao_len;
+    bool http10;
+
+    // Cabeçalho em leitura
+    char nome[HTTP_MAX_NOME_CAB + 1];    // Em minúsculas
+    uint8_t nome_len;
+    char valor[HTTP_MAX_VALOR_CAB + 1];  // Nas listas (Accept, Connection...), só o elemento atual
+    uint8_t valor_len;
+    bool valor_lista;                    // Valor avaliado elemento a elemento, a cada vírgula
+    uint16_t cabecalhos_len;
+
+    // Cabeçalhos conhecidos
+    bool tem_content_length;
+    uint32_t content_length;
+    bool aceita_gzip;
+    bool aceita_binario;                 // Accept inclui application/octet-stream
+    bool conexao_close;
+    bool conexao_keep_alive;
+    bool conexao_upgrade;                // Connection inclui "upgrade"
+    bool upgrade_websocket;              // Upgrade: websocket
+    char websocket_chave[25];            // Sec-WebSocket-Key (24 caracteres em base64)
+    uint8_t websocket_versao;            // Sec-WebSocket-Version
+
+    char corpo[HTTP_MAX_CORPO + 1];      // Terminado em '\0'
+    uint16_t corpo_len;
+} http_parser_t;
+
+// Prepara o parser para uma nova requisição
+void http_parser_iniciar(http_parser_t *p);
+
+// Consome até len bytes. Para logo após completar uma requisição (ou no primeiro
+// erro) e informa em *consumidos quantos bytes usou; o restante pertence à
+// próxima requisição em pipeline.
+http_parser_resultado_t http_parser_consumir(http_parser_t *p, const char *dados, size_t len, size_t *consumidos);
+
+// Indica se a conexão deve continuar aberta após responder a requisição
+bool http_parser_keep_alive(const http_parser_t *p);
+
+// Copia para valor (até len-1 bytes) o parâmetro chave da query, sem decodificar %XX.
+// Retorna false se o parâmetro não existe.
+bool http_query_valor(const char *query, const char *chave, char *valor, size_t len);
+
+// Texto padrão do status HTTP (ex.: 404 -> "404 Not Found")
+const char *http_status_texto(uint16_t status);
+
+#endif // HTTP_PARSER_H
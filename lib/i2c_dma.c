@@ -0,0 +1,152 @@
+#include "i2c_dma.h"
+
+#define FILA_MASCARA (I2C_DMA_FILA - 1)
+
+void i2c_dma_iniciar(i2c_dma_t *bus, i2c_inst_t *i2c, uint16_t *palavras, uint16_t capacidade) {
+    bus->i2c = i2c;
+    bus->palavras = palavras;
+    bus->capacidade = capacidade;
+    bus->livre = 0;
+    bus->cabeca = 0;
+    bus->cauda = 0;
+    bus->ocupado = false;
+    bus->erros = 0;
+    bus->aguardando = NULL;
+    bus->canal_dma = -1;
+    bus->canal_dma_leitura = -1;
+    bus->abortada = false;
+    i2c_dma_porta_iniciar(bus);
+}
+
+// Inicia a transação da cauda. Chamada com a seção crítica tomada.
+static void iniciar_proxima(i2c_dma_t *bus) {
+    bus->ocupado = true;
+    i2c_dma_porta_transferir(bus, &bus->fila[bus->cauda & FILA_MASCARA]);
+}
+
+void i2c_dma_concluir(i2c_dma_t *bus, bool erro) {
+    UBaseType_t estado = taskENTER_CRITICAL_FROM_ISR();
+    if (erro)
+        bus->erros++;
+    bus->cauda++;
+    if (bus->cauda != bus->cabeca)
+        iniciar_proxima(bus);
+    else
+        bus->ocupado = false;
+    TaskHandle_t tarefa = bus->aguardando;
+    taskEXIT_CRITICAL_FROM_ISR(estado);
+
+    if (tarefa) {
+        BaseType_t acordar = pdFALSE;
+        vTaskNotifyGiveFromISR(tarefa, &acordar);
+        portYIELD_FROM_ISR(acordar);
+    }
+}
+
+// Reserva n palavras contíguas no anel. As palavras em uso vão do início da transação
+// da cauda até livre; só a interrupção libera espaço, então a leitura da cauda aqui é
+// conservadora. Retorna -1 se não couber agora.
+static int reservar(i2c_dma_t *bus, uint16_t n) {
+    uint8_t cauda = bus->cauda;
+    if (cauda == bus->cabeca)
+        return 0;  // Fila vazia: o anel inteiro está livre
+    if ((uint8_t)(bus->cabeca - cauda) >= I2C_DMA_FILA)
+        return -1;
+
+    uint16_t usado = bus->fila[cauda & FILA_MASCARA].inicio;
+    if (bus->livre > usado) {
+        if (bus->capacidade - bus->livre >= n)
+            return bus->livre;
+        return n < usado ? 0 : -1;  // Volta ao início do anel
+    }
+    // Região em uso dá a volta: o espaço livre fica entre livre e usado
+    return bus->livre + n < usado ? bus->livre : -1;
+}
+
+// Registra a tarefa como a que espera. Na seção crítica: com o FreeRTOS SMP a
+// interrupção pode concluir no outro núcleo, e ela lê aguardando na mesma seção
+static void registrar_espera(i2c_dma_t *bus) {
+    taskENTER_CRITICAL();
+    bus->aguardando = xTaskGetCurrentTaskHandle();
+    taskEXIT_CRITICAL();
+}
+
+// Espera a próxima conclusão (ou qualquer notificação pendente)
+static bool esperar_notificacao(uint32_t timeout_ms) {
+    return ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms)) != 0;
+}
+
+// Monta a transação no anel e a publica; a primeira da fila já sai na hora
+static int enfileirar(i2c_dma_t *bus, uint8_t endereco, const uint8_t *escrita, size_t n_escrita,
+                      uint8_t *leitura, size_t n_leitura) {
+    size_t n = n_escrita + n_leitura;
+    if (n == 0 || n >= bus->capacidade)
+        return PICO_ERROR_GENERIC;
+
+    int inicio = reservar(bus, (uint16_t)n);
+    if (inicio < 0) {
+        registrar_espera(bus);
+        while ((inicio = reservar(bus, (uint16_t)n)) < 0) {
+            if (!esperar_notificacao(1000)) {
+                bus->aguardando = NULL;
+                return PICO_ERROR_GENERIC;
+            }
+        }
+        bus->aguardando = NULL;
+    }
+
+    uint16_t *palavras = &bus->palavras[inicio];
+    for (size_t i = 0; i < n_escrita; i++)
+        palavras[i] = escrita[i];
+    for (size_t i = n_escrita; i < n; i++)
+        palavras[i] = I2C_DMA_LEITURA;
+    if (n_escrita && n_leitura)
+        palavras[n_escrita] |= I2C_DMA_RESTART;
+    palavras[n - 1] |= I2C_DMA_STOP;
+
+    i2c_dma_transacao_t *t = &bus->fila[bus->cabeca & FILA_MASCARA];
+    t->endereco = endereco;
+    t->inicio = (uint16_t)inicio;
+    t->n = (uint16_t)n;
+    t->leitura = leitura;
+    t->n_leitura = (uint16_t)n_leitura;
+    bus->livre = (uint16_t)(inicio + n);
+
+    taskENTER_CRITICAL();
+    bus->cabeca++;
+    if (!bus->ocupado)
+        iniciar_proxima(bus);
+    taskEXIT_CRITICAL();
+    return 0;
+}
+
+int i2c_dma_escrever(i2c_dma_t *bus, uint8_t endereco, const uint8_t *dados, size_t len) {
+    int r = enfileirar(bus, endereco, dados, len, NULL, 0);
+    return r < 0 ? r : (int)len;
+}
+
+int i2c_dma_ler(i2c_dma_t *bus, uint8_t endereco, const uint8_t *escrita, size_t n_escrita,
+                uint8_t *leitura, size_t n_leitura) {
+    if (n_leitura == 0)
+        return PICO_ERROR_GENERIC;
+    int r = enfileirar(bus, endereco, escrita, n_escrita, leitura, n_leitura);
+    return r < 0 ? r : (int)n_leitura;
+}
+
+int i2c_dma_aguardar(i2c_dma_t *bus, uint32_t timeout_ms) {
+    // Registra-se antes de testar a fila: uma conclusão entre o teste e a espera fica
+    // guardada na notificação
+    registrar_espera(bus);
+    while (bus->cauda != bus->cabeca) {
+        if (!esperar_notificacao(timeout_ms)) {
+            bus->aguardando = NULL;
+            return PICO_ERROR_TIMEOUT;
+        }
+    }
+    bus->aguardando = NULL;
+
+    // Fila vazia: a interrupção não mexe mais nos erros até o próximo envio
+    uint16_t erros = bus->erros;
+    bus->erros = 0;
+    return erros ? PICO_ERROR_GENERIC : PICO_OK;
+}
@@ -0,0 +1,77 @@
+#ifndef I2C_DMA_H
+#define I2C_DMA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "hardware/i2c.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Fila de transações I2C assíncronas. Os bytes são convertidos em palavras no formato
+// do registrador IC_DATA_CMD e copiados para um anel do barramento; a porta (DMA no
+// RP2040, host/i2c_dma_sim.c na simulação) transmite uma transação por vez e avisa o
+// fim pela interrupção, que já inicia a próxima. Quem espera fica bloqueado numa
+// notificação de tarefa, sem ocupar a CPU.
+//
+// Um barramento tem um único produtor: só uma tarefa enfileira e espera nele.
+
+#define I2C_DMA_FILA 8  // Transações pendentes por barramento (potência de 2)
+
+// Bits de IC_DATA_CMD acima do byte de dados
+#define I2C_DMA_LEITURA (1u << 8)
+#define I2C_DMA_STOP    (1u << 9)
+#define I2C_DMA_RESTART (1u << 10)
+
+typedef struct {
+    uint8_t endereco;
+    uint16_t inicio;   // Posição no anel de palavras
+    uint16_t n;        // Palavras: bytes escritos + comandos de leitura
+    uint8_t *leitura;  // Destino dos bytes lidos (NULL em escritas)
+    uint16_t n_leitura;
+} i2c_dma_transacao_t;
+
+typedef struct {
+    i2c_inst_t *i2c;
+    uint16_t *palavras;                    // Anel com as palavras das transações pendentes
+    uint16_t capacidade;
+    uint16_t livre;                        // Próxima palavra livre (só a tarefa mexe)
+    i2c_dma_transacao_t fila[I2C_DMA_FILA];
+    volatile uint8_t cabeca;               // Próxima posição livre na fila (tarefa)
+    volatile uint8_t cauda;                // Transação em andamento (interrupção)
+    volatile bool ocupado;
+    volatile uint16_t erros;               // Transações abortadas (NACK, perda de arbitragem)
+    volatile TaskHandle_t aguardando;
+    // Estado da porta
+    int canal_dma;
+    int canal_dma_leitura;
+    volatile bool abortada;
+} i2c_dma_t;
+
+// Associa o barramento (já inicializado com i2c_init) a um anel de capacidade palavras
+void i2c_dma_iniciar(i2c_dma_t *bus, i2c_inst_t *i2c, uint16_t *palavras, uint16_t capacidade);
+
+// Enfileira a escrita de len bytes para endereco e retorna sem esperar o fim. dados
+// pode ser reutilizado logo após o retorno. Só bloqueia se o anel ou a fila estiverem
+// cheios. Retorna len ou PICO_ERROR_GENERIC (len maior que o anel, barramento parado).
+int i2c_dma_escrever(i2c_dma_t *bus, uint8_t endereco, const uint8_t *dados, size_t len);
+
+// Enfileira a escrita de n_escrita bytes (pode ser 0) seguida, com repeated start, da
+// leitura de n_leitura bytes para leitura. Os bytes só são válidos depois de
+// i2c_dma_aguardar retornar PICO_OK. Retorna n_leitura ou PICO_ERROR_GENERIC.
+int i2c_dma_ler(i2c_dma_t *bus, uint8_t endereco, const uint8_t *escrita, size_t n_escrita,
+                uint8_t *leitura, size_t n_leitura);
+
+// Bloqueia a tarefa até todas as transações enfileiradas terminarem. Retorna PICO_OK,
+// PICO_ERROR_GENERIC se alguma foi abortada desde a última espera ou PICO_ERROR_TIMEOUT.
+int i2c_dma_aguardar(i2c_dma_t *bus, uint32_t timeout_ms);
+
+// ---- Interface com a porta ----
+// Implementadas pela porta: preparação do hardware e início de uma transação
+void i2c_dma_porta_iniciar(i2c_dma_t *bus);
+void i2c_dma_porta_transferir(i2c_dma_t *bus, const i2c_dma_transacao_t *t);
+
+// Chamada pela porta, em contexto de interrupção, quando a transação em andamento termina
+void i2c_dma_concluir(i2c_dma_t *bus, bool erro);
+
+#endif // I2C_DMA_H
@@ -0,0 +1,89 @@
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "i2c_dma.h"
+
+// Porta RP2040 de i2c_dma: um canal de DMA alimenta IC_DATA_CMD com as palavras da
+// transação (16 bits por escrita, pacing pelo DREQ de TX do bloco I2C, que i2c_init já
+// habilita) e, nas leituras, um segundo canal esvazia a FIFO de RX pelo DREQ de RX.
+// O fim é detectado pela interrupção STOP_DET do próprio I2C, que só ocorre depois do
+// último byte passar no fio; TX_ABRT (NACK, arbitragem) interrompe o DMA e a transação
+// é concluída com erro no STOP que o controlador gera em seguida.
+//
+// As interrupções do I2C ficam mascaradas com o barramento ocioso, para não disputar
+// STOP_DET com eventuais chamadas bloqueantes do SDK no mesmo barramento.
+
+#define INTERRUPCOES (I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS)
+
+static i2c_dma_t *barramentos[2];
+
+static void tratar_irq(i2c_dma_t *bus) {
+    i2c_hw_t *hw = i2c_get_hw(bus->i2c);
+    uint32_t estado = hw->intr_stat;
+
+    if (estado & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        // A FIFO fica descartando escritas até o abort ser limpo: para o DMA antes
+        dma_channel_abort(bus->canal_dma);
+        dma_channel_abort(bus->canal_dma_leitura);
+        (void)hw->clr_tx_abrt;
+        bus->abortada = true;
+    }
+    if (estado & I2C_IC_INTR_STAT_R_STOP_DET_BITS) {
+        (void)hw->clr_stop_det;
+        hw->intr_mask = 0;
+        bool erro = bus->abortada;
+        bus->abortada = false;
+        // No STOP o último byte lido já está na FIFO; o DMA o retira em poucos ciclos
+        while (!erro && dma_channel_is_busy(bus->canal_dma_leitura))
+            tight_loop_contents();
+        i2c_dma_concluir(bus, erro);
+    }
+}
+
+static void irq_i2c0(void) {
+    tratar_irq(barramentos[0]);
+}
+
+static void irq_i2c1(void) {
+    tratar_irq(barramentos[1]);
+}
+
+void i2c_dma_porta_iniciar(i2c_dma_t *bus) {
+    uint indice = i2c_hw_index(bus->i2c);
+    barramentos[indice] = bus;
+
+    bus->canal_dma = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(bus->canal_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(bus->i2c, true));
+    dma_channel_configure(bus->canal_dma, &c, &i2c_get_hw(bus->i2c)->data_cmd, NULL, 0, false);
+
+    bus->canal_dma_leitura = dma_claim_unused_channel(true);
+    c = dma_channel_get_default_config(bus->canal_dma_leitura);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, i2c_get_dreq(bus->i2c, false));
+    dma_channel_configure(bus->canal_dma_leitura, &c, NULL, &i2c_get_hw(bus->i2c)->data_cmd, 0, false);
+
+    i2c_get_hw(bus->i2c)->intr_mask = 0;
+    uint irq = indice ? I2C1_IRQ : I2C0_IRQ;
+    irq_set_exclusive_handler(irq, indice ? irq_i2c1 : irq_i2c0);
+    irq_set_enabled(irq, true);
+}
+
+void i2c_dma_porta_transferir(i2c_dma_t *bus, const i2c_dma_transacao_t *t) {
+    i2c_hw_t *hw = i2c_get_hw(bus->i2c);
+    // Endereço do alvo só pode mudar com o bloco desabilitado (a FIFO está vazia aqui)
+    hw->enable = 0;
+    hw->tar = t->endereco;
+    hw->enable = 1;
+
+    (void)hw->clr_intr;
+    hw->intr_mask = INTERRUPCOES;
+    // RX primeiro: os comandos de leitura saem assim que o canal de TX começa
+    if (t->n_leitura)
+        dma_channel_transfer_to_buffer_now(bus->canal_dma_leitura, t->leitura, t->n_leitura);
+    dma_channel_transfer_from_buffer_now(bus->canal_dma, &bus->palavras[t->inicio], t->n);
+}
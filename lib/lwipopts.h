@@ -28,4 +28,10 @@
 #define LWIP_HTTPD_CGI 0 // Desative CGI para economizar memória
 #define LWIP_NETIF_HOSTNAME 1
 
+// Ocupação do heap e dos pools do lwIP, exposta em GET /stats
+#define LWIP_STATS 1
+#define MEM_STATS 1
+#define MEMP_STATS 1
+#define LWIP_STATS_DISPLAY 0
+
 #endif /* LWIPOPTS_H */
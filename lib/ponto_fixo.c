@@ -0,0 +1,68 @@
+#include "ponto_fixo.h"
+
+int ponto_fixo_formatar(char dst[PONTO_FIXO_TEXTO_MAX], int32_t centesimos) {
+    // Décimos arredondados em módulo; uint32 cobre INT32_MIN
+    uint32_t modulo = centesimos < 0 ? 0u - (uint32_t)centesimos : (uint32_t)centesimos;
+    uint32_t decimos = (modulo + 5) / 10;
+
+    // Dígitos de trás para frente: a casa decimal, o ponto e a parte inteira
+    char tmp[PONTO_FIXO_TEXTO_MAX];
+    int n = 0;
+    tmp[n++] = (char)('0' + decimos % 10);
+    tmp[n++] = '.';
+    decimos /= 10;
+    do {
+        tmp[n++] = (char)('0' + decimos % 10);
+        decimos /= 10;
+    } while (decimos);
+    // Sem "-0.0": o sinal só aparece se sobrou algo depois do arredondamento
+    if (centesimos < 0 && modulo >= 5)
+        tmp[n++] = '-';
+
+    int len = n;
+    for (int i = 0; i < len; i++)
+        dst[i] = tmp[--n];
+    dst[len] = '\0';
+    return len;
+}
+
+bool ponto_fixo_ler(const char *texto, int32_t *centesimos) {
+    const char *p = texto;
+    while (*p == ' ')
+        p++;
+    bool negativo = *p == '-';
+    if (*p == '-' || *p == '+')
+        p++;
+
+    int32_t inteiro = 0;
+    int digitos = 0;
+    for (; *p >= '0' && *p <= '9'; p++) {
+        if (++digitos > 7)
+            return false;
+        inteiro = inteiro * 10 + (*p - '0');
+    }
+
+    // Duas casas decimais; a terceira só decide o arredondamento
+    int32_t fracao = 0;
+    if (*p == '.') {
+        p++;
+        int casas = 0;
+        for (; *p >= '0' && *p <= '9'; p++, casas++) {
+            if (casas < 2)
+                fracao = fracao * 10 + (*p - '0');
+            else if (casas == 2 && *p >= '5')
+                fracao++;
+            digitos++;
+        }
+        if (casas == 1)
+            fracao *= 10;
+    }
+    while (*p == ' ')
+        p++;
+    if (digitos == 0 || *p != '\0')
+        return false;
+
+    int32_t valor = inteiro * PONTO_FIXO_ESCALA + fracao;
+    *centesimos = negativo ? -valor : valor;
+    return true;
+}
@@ -0,0 +1,23 @@
+#ifndef PONTO_FIXO_H
+#define PONTO_FIXO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Grandezas dos sensores em centésimos num int32 (2345 = 23,45 °C, % ou hPa; em hPa o
+// valor coincide com a pressão em Pa). O RP2040 não tem FPU: somas, comparações e a
+// saída em texto ficam em aritmética inteira, sem o printf de ponto flutuante.
+
+#define PONTO_FIXO_ESCALA 100
+#define PONTO_FIXO_TEXTO_MAX 13  // "-21474836.5" + '\0', com folga
+
+// Escreve o valor com uma casa decimal, arredondando a metade para longe do zero
+// (2345 -> "23.5", -5 -> "-0.1", -4 -> "0.0"). Retorna o comprimento do texto.
+int ponto_fixo_formatar(char dst[PONTO_FIXO_TEXTO_MAX], int32_t centesimos);
+
+// Lê "[+-]inteiro[.fração]" (ex.: valor de formulário) em centésimos, arredondando a
+// partir da terceira casa. Retorna false se o texto não é um número nesse formato ou
+// se não cabe em ±9999999,99.
+bool ponto_fixo_ler(const char *texto, int32_t *centesimos);
+
+#endif // PONTO_FIXO_H
@@ -0,0 +1,54 @@
+#include "pubsub.h"
+#include "task.h"
+
+// O assinante a ocupa os bits a * PUBSUB_TOPICOS .. a * PUBSUB_TOPICOS + PUBSUB_TOPICOS - 1
+#define BITS_ASSINANTE(a) ((EventBits_t)((1u << PUBSUB_TOPICOS) - 1) << ((a) * PUBSUB_TOPICOS))
+
+static EventGroupHandle_t grupo;
+static EventBits_t assinantes_topico[PUBSUB_TOPICOS];  // Bits a ligar em cada publicação
+static uint8_t total_assinantes;
+
+void pubsub_iniciar(void) {
+#if configSUPPORT_STATIC_ALLOCATION
+    static StaticEventGroup_t grupo_memoria;
+    grupo = xEventGroupCreateStatic(&grupo_memoria);
+#else
+    grupo = xEventGroupCreate();
+#endif
+}
+
+int pubsub_assinar(uint32_t topicos) {
+    taskENTER_CRITICAL();
+    int a = total_assinantes < PUBSUB_MAX_ASSINANTES ? total_assinantes++ : -1;
+    if (a >= 0) {
+        for (int t = 0; t < PUBSUB_TOPICOS; t++) {
+            if (topicos & PUBSUB_BIT(t))
+                assinantes_topico[t] |= (EventBits_t)1 << (a * PUBSUB_TOPICOS + t);
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (a >= 0)
+        xEventGroupSetBits(grupo, ((EventBits_t)topicos << (a * PUBSUB_TOPICOS)) & BITS_ASSINANTE(a));
+    return a;
+}
+
+uint32_t pubsub_aguardar(int assinante, TickType_t timeout) {
+    EventBits_t meus = BITS_ASSINANTE(assinante);
+    EventBits_t bits = xEventGroupWaitBits(grupo, meus, pdTRUE, pdFALSE, timeout);
+    return (uint32_t)((bits & meus) >> (assinante * PUBSUB_TOPICOS));
+}
+
+void pubsub_publicar(pubsub_topico_t topico) {
+    EventBits_t bits = assinantes_topico[topico];
+    if (!bits)
+        return;
+    if (portCHECK_IF_IN_ISR()) {
+        // Adiado para a tarefa de timers do kernel, como exige a versão FromISR
+        BaseType_t acordar = pdFALSE;
+        xEventGroupSetBitsFromISR(grupo, bits, &acordar);
+        portYIELD_FROM_ISR(acordar);
+    } else {
+        xEventGroupSetBits(grupo, bits);
+    }
+}
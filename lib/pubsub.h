@@ -0,0 +1,39 @@
+#ifndef PUBSUB_H
+#define PUBSUB_H
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "event_groups.h"
+
+// Avisos entre tarefas sobre um único event group do FreeRTOS. Cada assinante tem um
+// bit por tópico; publicar liga o bit do tópico em todos os assinantes dele e cada um
+// apaga só os seus ao acordar, então nenhum perde um aviso que outro já consumiu.
+// O aviso não carrega dados: o assinante lê o estado atual (ex.: leitura_obter).
+// Avisos repetidos antes de o assinante acordar viram um só.
+
+typedef enum {
+    PUBSUB_LEITURA,  // Nova leitura dos sensores publicada
+    PUBSUB_CONFIG,   // Limites, offsets ou perfil alterados
+    PUBSUB_REDE,     // Mudança no estado do Wi-Fi
+    PUBSUB_TOPICOS
+} pubsub_topico_t;
+
+#define PUBSUB_BIT(topico) (1u << (topico))
+#define PUBSUB_MAX_ASSINANTES 8  // 8 x 3 tópicos: os 24 bits de um event group
+
+// Cria o event group; chamar antes de criar as tarefas
+void pubsub_iniciar(void);
+
+// Registra um assinante dos tópicos da máscara (OR de PUBSUB_BIT). O primeiro
+// pubsub_aguardar já retorna, para o assinante partir do estado atual.
+// Retorna o assinante ou -1 se não houver mais vagas.
+int pubsub_assinar(uint32_t topicos);
+
+// Bloqueia até algum tópico assinado ser publicado. Retorna a máscara dos tópicos
+// recebidos (PUBSUB_BIT) ou 0 se o tempo esgotar.
+uint32_t pubsub_aguardar(int assinante, TickType_t timeout);
+
+// Avisa os assinantes do tópico. Pode ser chamada de tarefas ou de interrupções.
+void pubsub_publicar(pubsub_topico_t topico);
+
+#endif // PUBSUB_H
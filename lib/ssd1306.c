@@ -1,116 +1,191 @@
+#include <stdlib.h>
+#include <string.h>
 #include "ssd1306.h"
-#include "font.h"
+#include "font_colunas.h"
 
-void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
+void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c,
+                  uint64_t *columns, uint8_t *tx_buffer) {
   ssd->width = width;
   ssd->height = height;
   ssd->pages = height / 8U;
   ssd->address = address;
   ssd->i2c_port = i2c;
-  ssd->bufsize = ssd->pages * ssd->width + 1;
-  ssd->ram_buffer = calloc(ssd->bufsize, sizeof(uint8_t));
-  ssd->ram_buffer[0] = 0x40;
+  ssd->bufsize = ssd->pages * ssd->width;
+  // Uma palavra de 64 bits por coluna, mesmo com menos de 8 páginas
+  ssd->columns = columns;
+  memset(ssd->columns, 0, ssd->width * sizeof(uint64_t));
+  ssd->ram_buffer = (uint8_t *)ssd->columns;
   ssd->port_buffer[0] = 0x80;
+  ssd->tx_buffer = tx_buffer;
+  ssd->write_fn = NULL;
+  ssd->write_ctx = NULL;
+  ssd1306_invalidate(ssd);
+}
+
+// Troca o envio bloqueante por outro transporte (ex.: fila com DMA); NULL restaura o padrão
+void ssd1306_set_transport(ssd1306_t *ssd, ssd1306_write_fn_t write_fn, void *ctx) {
+  ssd->write_fn = write_fn;
+  ssd->write_ctx = ctx;
+}
+
+static void escrever(ssd1306_t *ssd, const uint8_t *src, size_t len) {
+  if (ssd->write_fn)
+    ssd->write_fn(ssd->write_ctx, ssd->address, src, len);
+  else
+    i2c_write_blocking(ssd->i2c_port, ssd->address, src, len, false);
+}
+
+// Marca o display inteiro para o próximo envio (ex.: após reconfigurar o controlador)
+void ssd1306_invalidate(ssd1306_t *ssd) {
+  for (uint8_t p = 0; p < ssd->pages; ++p) {
+    ssd->dirty_x0[p] = 0;
+    ssd->dirty_x1[p] = ssd->width - 1;
+  }
+}
+
+static inline void marcar_limpo(ssd1306_t *ssd, uint8_t page) {
+  ssd->dirty_x0[page] = 0xFF;
+  ssd->dirty_x1[page] = 0;
+}
+
+static inline void marcar_sujo(ssd1306_t *ssd, uint8_t page, uint8_t x) {
+  if (x < ssd->dirty_x0[page])
+    ssd->dirty_x0[page] = x;
+  if (x > ssd->dirty_x1[page])
+    ssd->dirty_x1[page] = x;
+}
+
+// Grava a coluna x marcando só as páginas cujo byte mudou
+static inline void escrever_coluna(ssd1306_t *ssd, uint8_t x, uint64_t coluna) {
+  uint64_t diferenca = ssd->columns[x] ^ coluna;
+  if (!diferenca)
+    return;
+  ssd->columns[x] = coluna;
+  while (diferenca) {
+    uint8_t page = (uint8_t)(__builtin_ctzll(diferenca) >> 3);
+    marcar_sujo(ssd, page, x);
+    diferenca &= ~(0xFFull << (page << 3));
+  }
+}
+
+// Grava o byte da página page na coluna x, marcando-o só se mudou
+static inline void escrever_byte(ssd1306_t *ssd, uint8_t x, uint8_t page, uint8_t byte) {
+  uint8_t *destino = &ssd->ram_buffer[(x << 3) + page];
+  if (*destino != byte) {
+    *destino = byte;
+    marcar_sujo(ssd, page, x);
+  }
+}
+
+// Liga ou desliga os pixels de mascara na coluna x
+static inline void aplicar_mascara(ssd1306_t *ssd, uint8_t x, uint64_t mascara, bool value) {
+  uint64_t coluna = ssd->columns[x];
+  escrever_coluna(ssd, x, value ? coluna | mascara : coluna & ~mascara);
+}
+
+// Bits y0..y1 (inclusive) de uma coluna, recortados à altura do display
+static inline uint64_t mascara_vertical(ssd1306_t *ssd, uint8_t y0, uint8_t y1) {
+  if (y1 >= ssd->height)
+    y1 = ssd->height - 1;
+  if (y0 > y1)
+    return 0;
+  return (~0ull >> (63 - y1)) & (~0ull << y0);
+}
+
+// Comandos em sequência numa única transação (byte de controle 0x00)
+static void enviar_comandos(ssd1306_t *ssd, const uint8_t *comandos, size_t len) {
+  uint8_t buf[32];
+  buf[0] = 0x00;
+  memcpy(buf + 1, comandos, len);
+  escrever(ssd, buf, len + 1);
 }
 
 void ssd1306_config(ssd1306_t *ssd) {
-  ssd1306_command(ssd, SET_DISP | 0x00);
-  ssd1306_command(ssd, SET_MEM_ADDR);
-  ssd1306_command(ssd, 0x01);
-  ssd1306_command(ssd, SET_DISP_START_LINE | 0x00);
-  ssd1306_command(ssd, SET_SEG_REMAP | 0x01);
-  ssd1306_command(ssd, SET_MUX_RATIO);
-  ssd1306_command(ssd, HEIGHT - 1);
-  ssd1306_command(ssd, SET_COM_OUT_DIR | 0x08);
-  ssd1306_command(ssd, SET_DISP_OFFSET);
-  ssd1306_command(ssd, 0x00);
-  ssd1306_command(ssd, SET_COM_PIN_CFG);
-  ssd1306_command(ssd, 0x12);
-  ssd1306_command(ssd, SET_DISP_CLK_DIV);
-  ssd1306_command(ssd, 0x80);
-  ssd1306_command(ssd, SET_PRECHARGE);
-  ssd1306_command(ssd, 0xF1);
-  ssd1306_command(ssd, SET_VCOM_DESEL);
-  ssd1306_command(ssd, 0x30);
-  ssd1306_command(ssd, SET_CONTRAST);
-  ssd1306_command(ssd, 0xFF);
-  ssd1306_command(ssd, SET_ENTIRE_ON);
-  ssd1306_command(ssd, SET_NORM_INV);
-  ssd1306_command(ssd, SET_CHARGE_PUMP);
-  ssd1306_command(ssd, 0x14);
-  ssd1306_command(ssd, SET_DISP | 0x01);
+  // A sequência inteira vai numa transação em vez de uma por comando
+  static const uint8_t comandos[] = {
+    SET_DISP | 0x00,
+    SET_MEM_ADDR, 0x01,
+    SET_DISP_START_LINE | 0x00,
+    SET_SEG_REMAP | 0x01,
+    SET_MUX_RATIO, HEIGHT - 1,
+    SET_COM_OUT_DIR | 0x08,
+    SET_DISP_OFFSET, 0x00,
+    SET_COM_PIN_CFG, 0x12,
+    SET_DISP_CLK_DIV, 0x80,
+    SET_PRECHARGE, 0xF1,
+    SET_VCOM_DESEL, 0x30,
+    SET_CONTRAST, 0xFF,
+    SET_ENTIRE_ON,
+    SET_NORM_INV,
+    SET_CHARGE_PUMP, 0x14,
+    SET_DISP | 0x01,
+  };
+  enviar_comandos(ssd, comandos, sizeof(comandos));
 }
 
 void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
   ssd->port_buffer[1] = command;
-  i2c_write_blocking(
-    ssd->i2c_port,
-    ssd->address,
-    ssd->port_buffer,
-    2,
-    false
-  );
+  escrever(ssd, ssd->port_buffer, 2);
 }
 
+// Envia só as páginas alteradas: cada sequência de páginas sujas vira uma janela com a
+// união das suas colunas. Em endereçamento vertical a janela é percorrida coluna a
+// coluna, como o ram_buffer, então os bytes são copiados em ordem para tx_buffer.
 void ssd1306_send_data(ssd1306_t *ssd) {
-  ssd1306_command(ssd, SET_COL_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->width - 1);
-  ssd1306_command(ssd, SET_PAGE_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->pages - 1);
-  i2c_write_blocking(
-    ssd->i2c_port,
-    ssd->address,
-    ssd->ram_buffer,
-    ssd->bufsize,
-    false
-  );
+  uint8_t p0 = 0;
+  while (p0 < ssd->pages) {
+    if (ssd->dirty_x0[p0] > ssd->dirty_x1[p0]) {
+      ++p0;
+      continue;
+    }
+    uint8_t p1 = p0, x0 = ssd->dirty_x0[p0], x1 = ssd->dirty_x1[p0];
+    while (p1 + 1 < ssd->pages && ssd->dirty_x0[p1 + 1] <= ssd->dirty_x1[p1 + 1]) {
+      ++p1;
+      if (ssd->dirty_x0[p1] < x0)
+        x0 = ssd->dirty_x0[p1];
+      if (ssd->dirty_x1[p1] > x1)
+        x1 = ssd->dirty_x1[p1];
+    }
+
+    const uint8_t janela[6] = {SET_COL_ADDR, x0, x1, SET_PAGE_ADDR, p0, p1};
+    enviar_comandos(ssd, janela, sizeof(janela));
+
+    uint8_t paginas = p1 - p0 + 1;
+    size_t len = 1;
+    ssd->tx_buffer[0] = 0x40;
+    for (uint8_t x = x0; x <= x1; ++x) {
+      memcpy(&ssd->tx_buffer[len], &ssd->ram_buffer[(x << 3) + p0], paginas);
+      len += paginas;
+    }
+    escrever(ssd, ssd->tx_buffer, len);
+
+    for (uint8_t p = p0; p <= p1; ++p)
+      marcar_limpo(ssd, p);
+    p0 = p1 + 1;
+  }
 }
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
-  uint16_t index = (y >> 3) + (x << 3) + 1;
-  uint8_t pixel = (y & 0b111);
-  if (value)
-    ssd->ram_buffer[index] |= (1 << pixel);
-  else
-    ssd->ram_buffer[index] &= ~(1 << pixel);
+  if (x >= ssd->width || y >= ssd->height)
+    return;
+  aplicar_mascara(ssd, x, 1ull << y, value);
 }
 
-/*
 void ssd1306_fill(ssd1306_t *ssd, bool value) {
-  uint8_t byte = value ? 0xFF : 0x00;
-  for (uint8_t i = 1; i < ssd->bufsize; ++i)
-    ssd->ram_buffer[i] = byte;
-}*/
-
-void ssd1306_fill(ssd1306_t *ssd, bool value) {
-    // Itera por todas as posições do display
-    for (uint8_t y = 0; y < ssd->height; ++y) {
-        for (uint8_t x = 0; x < ssd->width; ++x) {
-            ssd1306_pixel(ssd, x, y, value);
-        }
-    }
+  uint64_t coluna = value ? mascara_vertical(ssd, 0, ssd->height - 1) : 0;
+  for (uint8_t x = 0; x < ssd->width; ++x)
+    escrever_coluna(ssd, x, coluna);
 }
 
-
 void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
-  for (uint8_t x = left; x < left + width; ++x) {
-    ssd1306_pixel(ssd, x, top, value);
-    ssd1306_pixel(ssd, x, top + height - 1, value);
-  }
-  for (uint8_t y = top; y < top + height; ++y) {
-    ssd1306_pixel(ssd, left, y, value);
-    ssd1306_pixel(ssd, left + width - 1, y, value);
-  }
-
-  if (fill) {
-    for (uint8_t x = left + 1; x < left + width - 1; ++x) {
-      for (uint8_t y = top + 1; y < top + height - 1; ++y) {
-        ssd1306_pixel(ssd, x, y, value);
-      }
-    }
-  }
+  if (width == 0 || height == 0)
+    return;
+  uint8_t bottom = top + height - 1, right = left + width - 1;
+  // Colunas das bordas (e todas, se preenchido) recebem a altura inteira; as do meio, topo e base
+  uint64_t cheia = mascara_vertical(ssd, top, bottom);
+  uint64_t bordas = fill ? cheia : cheia & (mascara_vertical(ssd, top, top) | mascara_vertical(ssd, bottom, bottom));
+  for (uint16_t x = left; x <= right && x < ssd->width; ++x)
+    aplicar_mascara(ssd, x, x == left || x == right ? cheia : bordas, value);
 }
 
 void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value) {
@@ -143,53 +218,39 @@ void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1
 
 
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
-  for (uint8_t x = x0; x <= x1; ++x)
-    ssd1306_pixel(ssd, x, y, value);
+  uint64_t mascara = mascara_vertical(ssd, y, y);
+  for (uint16_t x = x0; x <= x1 && x < ssd->width; ++x)
+    aplicar_mascara(ssd, x, mascara, value);
 }
 
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
-  for (uint8_t y = y0; y <= y1; ++y)
-    ssd1306_pixel(ssd, x, y, value);
+  if (x < ssd->width)
+    aplicar_mascara(ssd, x, mascara_vertical(ssd, y0, y1), value);
 }
 
-// Função para desenhar um caractere
+// Função para desenhar um caractere. A fonte já vem em colunas (font_colunas.h, gerada
+// no build): com y múltiplo de 8 cada coluna é um byte de página; fora disso a coluna
+// é deslocada e mesclada nas duas páginas que a célula atravessa.
 void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y) {
-    uint16_t index = 0;
+  if (y >= ssd->height)
+    return;
 
-    // Mapear caracteres ASCII (32-126)
-    if (c >= 32 && c <= 126) {
-        index = (c - 32) * 8; // Desloca para começar no espaço (32)
-    }
-    // Mapear caracteres acentuados usando índices numéricos
-    else {
-        switch ((uint8_t)c) {
-            case 127: index = (127 - 32) * 8; break; // á
-            case 128: index = (128 - 32) * 8; break; // â
-            case 129: index = (129 - 32) * 8; break; // ã
-            case 130: index = (130 - 32) * 8; break; // à
-            case 131: index = (131 - 32) * 8; break; // ç
-            case 132: index = (132 - 32) * 8; break; // é
-            case 133: index = (133 - 32) * 8; break; // ê
-            case 134: index = (134 - 32) * 8; break; // í
-            case 135: index = (135 - 32) * 8; break; // ó
-            case 136: index = (136 - 32) * 8; break; // ô
-            case 137: index = (137 - 32) * 8; break; // õ
-            case 138: index = (138 - 32) * 8; break; // ú
-            case 139: index = (139 - 32) * 8; break; // ü
-            default: index = 0; // Usa espaço para caracteres não suportados
-        }
-    }
+  // ASCII (32-126) e acentuados (127-139) são contíguos na fonte; o resto vira espaço
+  uint8_t codigo = (uint8_t)c;
+  const uint8_t *glifo = font_colunas[codigo >= FONT_PRIMEIRO && codigo <= FONT_ULTIMO ? codigo - FONT_PRIMEIRO : 0];
 
-    // Renderizar o caractere como linhas horizontais, com inversão vertical e horizontal correta
-    for (uint8_t row = 0; row < 8; ++row) {
-        // Acessar bytes na ordem invertida: font[index + 7] é o topo, font[index + 0] é a base
-        uint8_t line = font[index + (7 - row)];
-        for (uint8_t col = 0; col < 8; ++col) {
-            // Mapear bits da esquerda para a direita: bit 7 à esquerda, bit 0 à direita
-            bool pixel = (line & (1 << (7 - col))) != 0;
-            ssd1306_pixel(ssd, x + col, y + row, pixel);
-        }
-    }
+  if ((y & 7) == 0) {
+    uint8_t page = y >> 3;
+    for (uint8_t col = 0; col < 8 && x + col < ssd->width; ++col)
+      escrever_byte(ssd, x + col, page, glifo[col]);
+    return;
+  }
+
+  uint64_t celula = mascara_vertical(ssd, y, y + 7);
+  for (uint8_t col = 0; col < 8 && x + col < ssd->width; ++col) {
+    uint64_t coluna = ssd->columns[x + col];
+    escrever_coluna(ssd, x + col, (coluna & ~celula) | (((uint64_t)glifo[col] << y) & celula));
+  }
 }
 
 // Função para desenhar uma string
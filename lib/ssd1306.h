@@ -1,9 +1,16 @@
-#include <stdlib.h>
+#include <stddef.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
 
 #define WIDTH 128
 #define HEIGHT 64
+#define SSD1306_MAX_PAGES (HEIGHT / 8)
+// Bytes do buffer de envio de um display width x height: controle + colunas x páginas
+#define SSD1306_TX_BYTES(width, height) ((size_t)(width) * ((height) / 8) + 1)
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "ssd1306: o framebuffer em palavras de 64 bits assume little-endian"
+#endif
 
 typedef enum {
   SET_CONTRAST = 0x81,
@@ -25,19 +32,37 @@ typedef enum {
   SET_CHARGE_PUMP = 0x8D
 } ssd1306_command_t;
 
+// Escrita de uma transação no barramento. src pode ser reutilizado assim que a função
+// retorna, então um transporte assíncrono precisa copiá-lo. Retorna len ou erro (< 0).
+typedef int (*ssd1306_write_fn_t)(void *ctx, uint8_t address, const uint8_t *src, size_t len);
+
 typedef struct {
   uint8_t width, height, pages, address;
   i2c_inst_t *i2c_port;
   bool external_vcc;
+  // Framebuffer em colunas: a palavra x tem o pixel (x, y) no bit y, ou seja, o byte
+  // da página p da coluna x fica em ram_buffer[x * 8 + p] (RP2040 é little-endian)
+  uint64_t *columns;
   uint8_t *ram_buffer;
   size_t bufsize;
   uint8_t port_buffer[2];
+  // Colunas alteradas em cada página desde o último envio (dirty_x0 > dirty_x1: página limpa)
+  uint8_t dirty_x0[SSD1306_MAX_PAGES];
+  uint8_t dirty_x1[SSD1306_MAX_PAGES];
+  uint8_t *tx_buffer;   // Janela a transmitir: byte de controle + colunas x páginas
+  ssd1306_write_fn_t write_fn;  // NULL: i2c_write_blocking em i2c_port
+  void *write_ctx;
 } ssd1306_t;
 
-void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c);
+// columns (width palavras) e tx_buffer (SSD1306_TX_BYTES(width, height) bytes) vêm de quem
+// chama, como o anel do i2c_dma: o driver não usa heap
+void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c,
+                  uint64_t *columns, uint8_t *tx_buffer);
 void ssd1306_config(ssd1306_t *ssd);
 void ssd1306_command(ssd1306_t *ssd, uint8_t command);
 void ssd1306_send_data(ssd1306_t *ssd);
+void ssd1306_invalidate(ssd1306_t *ssd);
+void ssd1306_set_transport(ssd1306_t *ssd, ssd1306_write_fn_t write_fn, void *ctx);
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value);
 void ssd1306_fill(ssd1306_t *ssd, bool value);
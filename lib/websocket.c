@@ -0,0 +1,283 @@
+#include <string.h>
+#include "websocket.h"
+
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+enum {
+    ESTADO_CABECALHO,
+    ESTADO_PAYLOAD,
+    ESTADO_COMPLETO,
+    ESTADO_ERRO
+};
+
+// ===================== SHA-1 =====================
+// Usado só no handshake; implementação compacta para não depender do mbedTLS.
+static uint32_t rotl(uint32_t v, int n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+static void sha1_bloco(uint32_t h[5], const uint8_t bloco[64]) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++)
+        w[i] = (uint32_t)bloco[i * 4] << 24 | (uint32_t)bloco[i * 4 + 1] << 16 |
+               (uint32_t)bloco[i * 4 + 2] << 8 | bloco[i * 4 + 3];
+    for (int i = 16; i < 80; i++)
+        w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = rotl(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rotl(b, 30);
+        b = a;
+        a = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+static void sha1(const uint8_t *dados, size_t len, uint8_t hash[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    uint8_t bloco[64];
+    size_t i = 0;
+
+    for (; i + 64 <= len; i += 64)
+        sha1_bloco(h, dados + i);
+
+    // Último bloco: resto + 0x80 + zeros + tamanho em bits (big-endian)
+    size_t resto = len - i;
+    memset(bloco, 0, sizeof(bloco));
+    memcpy(bloco, dados + i, resto);
+    bloco[resto] = 0x80;
+    if (resto >= 56) {
+        sha1_bloco(h, bloco);
+        memset(bloco, 0, sizeof(bloco));
+    }
+    uint64_t bits = (uint64_t)len * 8;
+    for (int j = 0; j < 8; j++)
+        bloco[63 - j] = (uint8_t)(bits >> (j * 8));
+    sha1_bloco(h, bloco);
+
+    for (int j = 0; j < 5; j++) {
+        hash[j * 4] = (uint8_t)(h[j] >> 24);
+        hash[j * 4 + 1] = (uint8_t)(h[j] >> 16);
+        hash[j * 4 + 2] = (uint8_t)(h[j] >> 8);
+        hash[j * 4 + 3] = (uint8_t)h[j];
+    }
+}
+
+// ===================== BASE64 =====================
+static size_t base64_codificar(const uint8_t *dados, size_t len, char *saida) {
+    static const char alfabeto[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t n = 0;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)dados[i] << 16;
+        if (i + 1 < len)
+            v |= (uint32_t)dados[i + 1] << 8;
+        if (i + 2 < len)
+            v |= dados[i + 2];
+        saida[n++] = alfabeto[(v >> 18) & 0x3F];
+        saida[n++] = alfabeto[(v >> 12) & 0x3F];
+        saida[n++] = i + 1 < len ? alfabeto[(v >> 6) & 0x3F] : '=';
+        saida[n++] = i + 2 < len ? alfabeto[v & 0x3F] : '=';
+    }
+    saida[n] = '\0';
+    return n;
+}
+
+void ws_calcular_accept(const char *chave, char *saida) {
+    char concatenada[WS_TAMANHO_CHAVE + sizeof(WS_GUID)];
+    size_t len = strlen(chave);
+    if (len > WS_TAMANHO_CHAVE)
+        len = WS_TAMANHO_CHAVE;
+    memcpy(concatenada, chave, len);
+    memcpy(concatenada + len, WS_GUID, sizeof(WS_GUID) - 1);
+
+    uint8_t hash[20];
+    sha1((const uint8_t *)concatenada, len + sizeof(WS_GUID) - 1, hash);
+    base64_codificar(hash, sizeof(hash), saida);
+}
+
+// ===================== FRAMES =====================
+void ws_parser_iniciar(ws_parser_t *p) {
+    p->estado = ESTADO_CABECALHO;
+    p->codigo_erro = 0;
+    p->cab_len = 0;
+    p->cab_necessario = 2;
+    p->opcode_mensagem = 0;
+    p->mensagem_len = 0;
+    p->controle_len = 0;
+    p->concluido = 0;
+}
+
+static ws_parser_resultado_t falhar(ws_parser_t *p, uint16_t codigo) {
+    p->estado = ESTADO_ERRO;
+    p->codigo_erro = codigo;
+    return WS_PARSER_ERRO;
+}
+
+static bool opcode_controle(uint8_t opcode) {
+    return opcode & 0x8;
+}
+
+// Conclui um frame cujo payload já foi lido. Retorna COMPLETO se há algo a entregar.
+static ws_parser_resultado_t concluir_frame(ws_parser_t *p) {
+    p->estado = ESTADO_CABECALHO;
+    p->cab_len = 0;
+    p->cab_necessario = 2;
+
+    if (opcode_controle(p->opcode)) {
+        p->controle[p->controle_len] = '\0';
+        p->concluido = p->opcode;
+        p->estado = ESTADO_COMPLETO;
+        return WS_PARSER_COMPLETO;
+    }
+    if (!p->fin)
+        return WS_PARSER_INCOMPLETO;  // Aguarda os próximos fragmentos
+
+    p->mensagem[p->mensagem_len] = '\0';
+    p->concluido = p->opcode_mensagem;
+    p->estado = ESTADO_COMPLETO;
+    return WS_PARSER_COMPLETO;
+}
+
+// Valida o cabeçalho completo do frame e prepara a leitura do payload
+static ws_parser_resultado_t iniciar_payload(ws_parser_t *p) {
+    uint8_t len7 = p->cab[1] & 0x7F;
+    uint64_t len = len7;
+    uint8_t pos = 2;
+    if (len7 == 126) {
+        len = (uint64_t)p->cab[2] << 8 | p->cab[3];
+        pos = 4;
+    } else if (len7 == 127) {
+        len = 0;
+        for (int i = 0; i < 8; i++)
+            len = len << 8 | p->cab[2 + i];
+        pos = 10;
+    }
+    memcpy(p->mascara, &p->cab[pos], 4);
+
+    if (opcode_controle(p->opcode)) {
+        if (!p->fin || len > WS_MAX_CONTROLE)
+            return falhar(p, WS_FECHAMENTO_PROTOCOLO);
+        p->controle_len = 0;
+    } else if (p->opcode == WS_OP_CONTINUACAO) {
+        if (!p->opcode_mensagem)
+            return falhar(p, WS_FECHAMENTO_PROTOCOLO);
+    } else if (p->opcode == WS_OP_TEXTO || p->opcode == WS_OP_BINARIO) {
+        if (p->opcode_mensagem)
+            return falhar(p, WS_FECHAMENTO_PROTOCOLO);
+        p->opcode_mensagem = p->opcode;
+        p->mensagem_len = 0;
+    } else {
+        return falhar(p, WS_FECHAMENTO_PROTOCOLO);
+    }
+
+    if (!opcode_controle(p->opcode) && p->mensagem_len + len > WS_MAX_PAYLOAD)
+        return falhar(p, WS_FECHAMENTO_GRANDE_DEMAIS);
+
+    p->restante = (uint32_t)len;
+    p->posicao = 0;
+    p->estado = ESTADO_PAYLOAD;
+    if (p->restante == 0)
+        return concluir_frame(p);
+    return WS_PARSER_INCOMPLETO;
+}
+
+ws_parser_resultado_t ws_parser_consumir(ws_parser_t *p, const uint8_t *dados, size_t len, size_t *consumidos) {
+    size_t i = 0;
+    ws_parser_resultado_t res = WS_PARSER_INCOMPLETO;
+
+    if (p->estado == ESTADO_ERRO) {
+        *consumidos = 0;
+        return WS_PARSER_ERRO;
+    }
+    if (p->estado == ESTADO_COMPLETO) {
+        // A unidade anterior já foi entregue: libera a mensagem para a próxima
+        if (!opcode_controle(p->concluido)) {
+            p->opcode_mensagem = 0;
+            p->mensagem_len = 0;
+        }
+        p->concluido = 0;
+        p->estado = ESTADO_CABECALHO;
+    }
+
+    while (i < len && res == WS_PARSER_INCOMPLETO) {
+        if (p->estado == ESTADO_CABECALHO) {
+            p->cab[p->cab_len++] = dados[i++];
+            if (p->cab_len == 2) {
+                // Bits RSV exigem extensão negociada; frames do cliente devem vir mascarados
+                if ((p->cab[0] & 0x70) || !(p->cab[1] & 0x80)) {
+                    res = falhar(p, WS_FECHAMENTO_PROTOCOLO);
+                    break;
+                }
+                p->fin = p->cab[0] & 0x80;
+                p->opcode = p->cab[0] & 0x0F;
+                uint8_t len7 = p->cab[1] & 0x7F;
+                p->cab_necessario = 2 + (len7 == 126 ? 2 : len7 == 127 ? 8 : 0) + 4;
+            }
+            if (p->cab_len == p->cab_necessario)
+                res = iniciar_payload(p);
+            continue;
+        }
+
+        // Payload: desmascara direto no buffer de destino
+        size_t n = len - i;
+        if (n > p->restante)
+            n = p->restante;
+        uint8_t *destino = opcode_controle(p->opcode) ? p->controle + p->controle_len : p->mensagem + p->mensagem_len;
+        for (size_t j = 0; j < n; j++)
+            destino[j] = dados[i + j] ^ p->mascara[(p->posicao + j) & 3];
+        if (opcode_controle(p->opcode))
+            p->controle_len += (uint8_t)n;
+        else
+            p->mensagem_len += (uint16_t)n;
+        p->posicao += (uint32_t)n;
+        p->restante -= (uint32_t)n;
+        i += n;
+        if (p->restante == 0)
+            res = concluir_frame(p);
+    }
+
+    *consumidos = i;
+    return res;
+}
+
+uint8_t *ws_parser_dados(ws_parser_t *p, size_t *len) {
+    if (opcode_controle(p->concluido)) {
+        *len = p->controle_len;
+        return p->controle;
+    }
+    *len = p->mensagem_len;
+    return p->mensagem;
+}
+
+size_t ws_montar_cabecalho(uint8_t *buf, ws_opcode_t opcode, size_t payload_len) {
+    buf[0] = 0x80 | (uint8_t)opcode;
+    if (payload_len < 126) {
+        buf[1] = (uint8_t)payload_len;
+        return 2;
+    }
+    buf[1] = 126;
+    buf[2] = (uint8_t)(payload_len >> 8);
+    buf[3] = (uint8_t)payload_len;
+    return 4;
+}
@@ -0,0 +1,80 @@
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// WebSocket (RFC 6455) do lado do servidor: handshake, parser incremental dos frames
+// enviados pelo cliente e montagem dos cabeçalhos dos frames enviados pelo servidor.
+
+#define WS_MAX_PAYLOAD      512   // Maior mensagem aceita do cliente (após remontar fragmentos)
+#define WS_MAX_CONTROLE     125   // Limite do RFC para frames de controle
+#define WS_TAMANHO_CHAVE    24    // Sec-WebSocket-Key: 16 bytes em base64
+#define WS_TAMANHO_ACCEPT   28    // Sec-WebSocket-Accept: SHA-1 (20 bytes) em base64
+#define WS_MAX_CABECALHO    4     // Frames do servidor: sem máscara e com payload < 64 KiB
+
+// Códigos de fechamento usados pelo servidor
+#define WS_FECHAMENTO_NORMAL        1000
+#define WS_FECHAMENTO_PROTOCOLO     1002
+#define WS_FECHAMENTO_NAO_SUPORTADO 1003
+#define WS_FECHAMENTO_GRANDE_DEMAIS 1009
+
+typedef enum {
+    WS_OP_CONTINUACAO = 0x0,
+    WS_OP_TEXTO       = 0x1,
+    WS_OP_BINARIO     = 0x2,
+    WS_OP_FECHAR      = 0x8,
+    WS_OP_PING        = 0x9,
+    WS_OP_PONG        = 0xA
+} ws_opcode_t;
+
+typedef enum {
+    WS_PARSER_INCOMPLETO,  // Precisa de mais bytes
+    WS_PARSER_COMPLETO,    // Mensagem de dados ou frame de controle disponível
+    WS_PARSER_ERRO         // Violação do protocolo; ver ws_parser_t.codigo_erro
+} ws_parser_resultado_t;
+
+typedef struct {
+    uint8_t estado;
+    uint16_t codigo_erro;                // Código de fechamento a enviar quando WS_PARSER_ERRO
+
+    // Frame em leitura
+    uint8_t cab[14];
+    uint8_t cab_len;
+    uint8_t cab_necessario;
+    uint8_t opcode;
+    bool fin;
+    uint8_t mascara[4];
+    uint32_t restante;                   // Bytes do payload do frame ainda por ler
+    uint32_t posicao;                    // Posição no payload do frame (índice da máscara)
+
+    // Mensagem de dados, possivelmente fragmentada em vários frames
+    uint8_t opcode_mensagem;             // 0 quando não há mensagem em andamento
+    uint16_t mensagem_len;
+    uint8_t mensagem[WS_MAX_PAYLOAD + 1];
+
+    // Frames de controle podem chegar entre fragmentos de uma mensagem
+    uint8_t controle_len;
+    uint8_t controle[WS_MAX_CONTROLE + 1];
+
+    uint8_t concluido;                   // Opcode da unidade concluída (texto, binário, fechar, ping, pong)
+} ws_parser_t;
+
+// Calcula Sec-WebSocket-Accept para a chave do cliente. saida recebe
+// WS_TAMANHO_ACCEPT caracteres mais o '\0'.
+void ws_calcular_accept(const char *chave, char *saida);
+
+void ws_parser_iniciar(ws_parser_t *p);
+
+// Consome até len bytes, parando ao concluir uma mensagem ou frame de controle.
+// Os dados concluídos (ws_parser_dados) valem até a próxima chamada.
+ws_parser_resultado_t ws_parser_consumir(ws_parser_t *p, const uint8_t *dados, size_t len, size_t *consumidos);
+
+// Payload da unidade concluída, terminado em '\0' (texto pode ser tratado como string)
+uint8_t *ws_parser_dados(ws_parser_t *p, size_t *len);
+
+// Escreve o cabeçalho de um frame do servidor (FIN, sem máscara) e retorna seu tamanho
+size_t ws_montar_cabecalho(uint8_t *buf, ws_opcode_t opcode, size_t payload_len);
+
+#endif // WEBSOCKET_H
@@ -0,0 +1,273 @@
+#!/usr/bin/env python3
+"""Gera o cabeçalho C com a página web embutida no firmware.
+
+Minifica o HTML/CSS/JS de web/index.html e emite:
+  - html_page[]    : página minificada sem compressão (fallback identity)
+  - html_page_gz[] : a mesma página comprimida com gzip (Content-Encoding: gzip)
+
+Uso: embed_html.py <entrada.html> <saida.h> [--no-identity]
+"""
+
+import gzip
+import os
+import re
+import sys
+
+PONTUACAO_CSS = set("{}:;,>")
+PONTUACAO_JS = set("{}()[];,:=<>+-*/&|?!")
+
+# Depois destas palavras uma "/" abre uma expressão regular, não uma divisão
+PALAVRAS_ANTES_DE_REGEX = {"return", "typeof", "case", "do", "else", "in", "of", "new", "delete",
+                           "void", "throw", "instanceof", "yield", "await"}
+# Uma quebra de linha só pode sumir se o comando continua de qualquer jeito: depois de um
+# destes (a linha não termina ali) ou antes de um destes (o ASI não agiria no lugar)
+FIM_CONTINUA = set("{([,;:=<>?&|!~*%^")
+INICIO_CONTINUA = set(")]},;:.?=")
+
+
+class ErroMinificacao(Exception):
+    pass
+
+
+def minificar_css(texto):
+    """Remove comentários e espaços em volta de pontuação do CSS."""
+    texto = re.sub(r"/\*.*?\*/", "", texto, flags=re.S)
+    saida = []
+    espaco = False
+    for c in texto:
+        if c.isspace():
+            espaco = True
+            continue
+        anterior = saida[-1] if saida else ""
+        if espaco and anterior and anterior not in PONTUACAO_CSS and c not in PONTUACAO_CSS:
+            saida.append(" ")
+        espaco = False
+        saida.append(c)
+    return "".join(saida)
+
+
+def identificador(c):
+    return c.isalnum() or c in "_$"
+
+
+def fim_string(texto, i):
+    """Índice logo após a string iniciada em texto[i] (aspas simples ou duplas)."""
+    aspas = texto[i]
+    j = i + 1
+    while j < len(texto) and texto[j] != aspas:
+        if texto[j] == "\n":
+            raise ErroMinificacao("string sem fechamento na linha %d" % (texto.count("\n", 0, i) + 1))
+        j += 2 if texto[j] == "\\" else 1
+    if j >= len(texto):
+        raise ErroMinificacao("string sem fechamento na linha %d" % (texto.count("\n", 0, i) + 1))
+    return j + 1
+
+
+def fim_template(texto, i):
+    """Índice logo após o template iniciado em texto[i], com ${...} aninhados."""
+    j = i + 1
+    while j < len(texto):
+        c = texto[j]
+        if c == "\\":
+            j += 2
+        elif c == "`":
+            return j + 1
+        elif texto.startswith("${", j):
+            j = fim_expressao(texto, j + 2)
+        else:
+            j += 1
+    raise ErroMinificacao("template sem fechamento na linha %d" % (texto.count("\n", 0, i) + 1))
+
+
+def fim_expressao(texto, i):
+    """Índice logo após o "}" que fecha uma expressão ${...} começada em i."""
+    nivel = 0
+    j = i
+    while j < len(texto):
+        c = texto[j]
+        if c in "'\"":
+            j = fim_string(texto, j)
+            continue
+        if c == "`":
+            j = fim_template(texto, j)
+            continue
+        if c == "{":
+            nivel += 1
+        elif c == "}":
+            if nivel == 0:
+                return j + 1
+            nivel -= 1
+        j += 1
+    raise ErroMinificacao("expressão ${ sem fechamento na linha %d" % (texto.count("\n", 0, i) + 1))
+
+
+def fim_regex(texto, i):
+    """Índice logo após a "/" que fecha a expressão regular iniciada em texto[i]."""
+    j = i + 1
+    classe = False
+    while j < len(texto) and texto[j] != "\n":
+        c = texto[j]
+        if c == "\\":
+            j += 2
+            continue
+        if c == "[":
+            classe = True
+        elif c == "]":
+            classe = False
+        elif c == "/" and not classe:
+            return j + 1
+        j += 1
+    raise ErroMinificacao("expressão regular sem fechamento na linha %d" % (texto.count("\n", 0, i) + 1))
+
+
+def minificar_js(texto):
+    """Minifica JavaScript sem mudar o significado.
+
+    Comentários saem, e strings, templates e expressões regulares são copiados intactos.
+    Espaços só ficam entre dois identificadores ou entre operadores que se fundiriam
+    ("+ +"). Uma quebra de linha só some onde a inserção automática de ";" não poderia
+    agir; nos outros lugares vira um "\\n", que o gzip comprime quase de graça.
+    """
+    saida = []
+    palavra = None         # Último token, se for um identificador ou palavra-chave
+    espaco = quebra = False
+    i = 0
+    n = len(texto)
+    while i < n:
+        c = texto[i]
+        if c.isspace():
+            espaco = True
+            quebra = quebra or c == "\n"
+            i += 1
+            continue
+        if texto.startswith("//", i):
+            fim = texto.find("\n", i)
+            i = n if fim < 0 else fim
+            continue
+        if texto.startswith("/*", i):
+            fim = texto.find("*/", i + 2)
+            if fim < 0:
+                raise ErroMinificacao("comentário sem fechamento na linha %d" % (texto.count("\n", 0, i) + 1))
+            espaco = True
+            quebra = quebra or "\n" in texto[i:fim]
+            i = fim + 2
+            continue
+
+        anterior = saida[-1][-1] if saida else ""
+        if espaco and anterior:
+            antes = saida[-1][-2:-1] if len(saida[-1]) > 1 else (saida[-2][-1:] if len(saida) > 1 else "")
+            continua = (anterior in FIM_CONTINUA or c in INICIO_CONTINUA or
+                        (anterior in "+-" and antes != anterior))
+            if quebra and not continua:
+                saida.append("\n")
+            elif (anterior not in PONTUACAO_JS and c not in PONTUACAO_JS) or (anterior in "+-" and c == anterior):
+                saida.append(" ")
+        espaco = quebra = False
+
+        if c in "'\"":
+            fim = fim_string(texto, i)
+        elif c == "`":
+            fim = fim_template(texto, i)
+        elif c == "/" and (palavra in PALAVRAS_ANTES_DE_REGEX if palavra else anterior not in ")]\"'`" and
+                           not identificador(anterior)):
+            fim = fim_regex(texto, i)
+        elif identificador(c):
+            fim = i + 1
+            while fim < n and identificador(texto[fim]):
+                fim += 1
+            saida.append(texto[i:fim])
+            palavra = texto[i:fim]
+            i = fim
+            continue
+        else:
+            fim = i + 1
+        saida.append(texto[i:fim])
+        palavra = None
+        i = fim
+    return "".join(saida)
+
+
+def minificar(html):
+    """Minifica a página: <style> e <script> pelos minificadores próprios, o resto linha a linha."""
+    partes = re.split(r"(<style>.*?</style>|<script>.*?</script>)", html, flags=re.S)
+    saida = []
+    for parte in partes:
+        if parte.startswith("<style>"):
+            saida.append("<style>" + minificar_css(parte[7:-8]) + "</style>")
+        elif parte.startswith("<script>"):
+            saida.append("<script>" + minificar_js(parte[8:-9]) + "</script>")
+        else:
+            parte = re.sub(r"<!--.*?-->", "", parte, flags=re.S)
+            saida.append("".join(linha.strip() for linha in parte.splitlines()))
+    return "".join(saida)
+
+
+def literal_c(dados, largura=100):
+    linhas = []
+    atual = ""
+    for ch in dados.decode("utf-8"):
+        if ch == "\\":
+            atual += "\\\\"
+        elif ch == '"':
+            atual += '\\"'
+        elif ch == "\n":
+            atual += "\\n"
+        else:
+            atual += ch
+        if len(atual) >= largura:
+            linhas.append('    "%s"' % atual)
+            atual = ""
+    if atual:
+        linhas.append('    "%s"' % atual)
+    return "\n".join(linhas)
+
+
+def array_c(dados, por_linha=16):
+    linhas = []
+    for i in range(0, len(dados), por_linha):
+        linhas.append("    " + ", ".join("0x%02x" % b for b in dados[i:i + por_linha]) + ",")
+    return "\n".join(linhas)
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit(__doc__)
+    entrada, saida = sys.argv[1], sys.argv[2]
+    identity = "--no-identity" not in sys.argv[3:]
+
+    with open(entrada, encoding="utf-8") as f:
+        try:
+            pagina = minificar(f.read()).encode("utf-8")
+        except ErroMinificacao as erro:
+            sys.exit("embed_html.py: %s: %s" % (entrada, erro))
+    # mtime fixo para o build ser reprodutível
+    comprimida = gzip.compress(pagina, compresslevel=9, mtime=0)
+
+    partes = [
+        "// Gerado por tools/embed_html.py a partir de web/index.html. Não editar.",
+        "// Página minificada: %d bytes; gzip: %d bytes." % (len(pagina), len(comprimida)),
+        "#ifndef HTML_PAGE_H",
+        "#define HTML_PAGE_H",
+        "",
+        "#include <stdint.h>",
+        "",
+        "#define HTML_PAGE_HAS_IDENTITY %d" % (1 if identity else 0),
+        "",
+    ]
+    if identity:
+        partes += ["static const char html_page[] =", literal_c(pagina) + ";", ""]
+    partes += [
+        "static const uint8_t html_page_gz[%d] = {" % len(comprimida),
+        array_c(comprimida),
+        "};",
+        "",
+        "#endif // HTML_PAGE_H",
+        "",
+    ]
+    os.makedirs(os.path.dirname(os.path.abspath(saida)), exist_ok=True)
+    with open(saida, "w", encoding="utf-8") as f:
+        f.write("\n".join(partes))
+
+
+if __name__ == "__main__":
+    main()
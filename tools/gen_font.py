@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""Gera a fonte do display transposta para o layout do framebuffer do SSD1306.
+
+lib/font.h guarda cada glifo 8x8 em linhas, de baixo para cima, com o bit 7 na
+coluna da esquerda. O framebuffer é organizado em colunas de páginas de 8 pixels
+verticais (bit 0 no topo), então o glifo é emitido como 8 bytes de coluna:
+  - font_colunas[g][c] : coluna c do glifo g, bit r = linha r a partir do topo
+
+Assim desenhar um caractere alinhado a uma página são 8 gravações de byte.
+
+Uso: gen_font.py <font.h> <saida.h>
+"""
+
+import os
+import re
+import sys
+
+PRIMEIRO_CARACTERE = 32
+
+
+def ler_fonte(caminho):
+    with open(caminho, encoding="utf-8") as f:
+        texto = f.read()
+    corpo = re.search(r"font\[\]\s*=\s*\{(.*?)\};", texto, flags=re.S)
+    if not corpo:
+        sys.exit("gen_font.py: tabela font[] não encontrada em %s" % caminho)
+    # Comentários podem conter '0x'; só os valores contam
+    valores = re.sub(r"//[^\n]*", "", corpo.group(1))
+    dados = [int(v, 16) for v in re.findall(r"0x[0-9A-Fa-f]{2}", valores)]
+    if len(dados) % 8:
+        sys.exit("gen_font.py: font[] tem %d bytes, não múltiplo de 8" % len(dados))
+    return [dados[i:i + 8] for i in range(0, len(dados), 8)]
+
+
+def transpor(glifo):
+    # glifo[7] é a linha do topo; bit (7 - c) da linha é a coluna c
+    colunas = []
+    for c in range(8):
+        coluna = 0
+        for r in range(8):
+            if glifo[7 - r] & (1 << (7 - c)):
+                coluna |= 1 << r
+        colunas.append(coluna)
+    return colunas
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit(__doc__)
+    entrada, saida = sys.argv[1], sys.argv[2]
+
+    glifos = ler_fonte(entrada)
+    ultimo = PRIMEIRO_CARACTERE + len(glifos) - 1
+    linhas = []
+    for i, glifo in enumerate(glifos):
+        codigo = PRIMEIRO_CARACTERE + i
+        rotulo = "espaço" if codigo == 32 else chr(codigo) if codigo < 127 else "acentuado"
+        linhas.append("    {%s}, // %d %s" % (", ".join("0x%02x" % b for b in transpor(glifo)), codigo,
+                                             rotulo.replace("\\", "barra")))
+
+    partes = [
+        "// Gerado por tools/gen_font.py a partir de lib/font.h. Não editar.",
+        "#ifndef FONT_COLUNAS_H",
+        "#define FONT_COLUNAS_H",
+        "",
+        "#include <stdint.h>",
+        "",
+        "#define FONT_PRIMEIRO %d" % PRIMEIRO_CARACTERE,
+        "#define FONT_ULTIMO %d" % ultimo,
+        "",
+        "static const uint8_t font_colunas[%d][8] = {" % len(glifos),
+        "\n".join(linhas),
+        "};",
+        "",
+        "#endif // FONT_COLUNAS_H",
+        "",
+    ]
+    os.makedirs(os.path.dirname(os.path.abspath(saida)), exist_ok=True)
+    with open(saida, "w", encoding="utf-8") as f:
+        f.write("\n".join(partes))
+
+
+if __name__ == "__main__":
+    main()
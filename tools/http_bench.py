@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""Mede a latência HTTP da estação (GET /json, uma conexão nova por requisição).
+
+Para comparar um e dois núcleos sob carga do display, grave o firmware com
+-DWEATHER_STATION_DISPLAY_CONTINUO=ON e, em seguida, com e sem
+-DWEATHER_STATION_SMP=ON, e rode o script contra cada um:
+
+  http_bench.py 192.168.0.50 -n 500 --rotulo smp
+
+Cada execução imprime uma linha com mínimo, mediana, p95, p99 e máximo em ms;
+com --csv os tempos de cada requisição também são gravados.
+
+Uso: http_bench.py <host[:porta]> [-n N] [--caminho /json] [--rotulo texto] [--csv arquivo]
+"""
+
+import argparse
+import http.client
+import statistics
+import sys
+import time
+
+
+def medir(host, porta, caminho, timeout):
+    inicio = time.perf_counter()
+    conexao = http.client.HTTPConnection(host, porta, timeout=timeout)
+    try:
+        conexao.request("GET", caminho, headers={"Connection": "close"})
+        resposta = conexao.getresponse()
+        resposta.read()
+        if resposta.status != 200:
+            raise RuntimeError("status %d" % resposta.status)
+    finally:
+        conexao.close()
+    return (time.perf_counter() - inicio) * 1000.0
+
+
+def percentil(ordenados, p):
+    indice = min(len(ordenados) - 1, int(round(p / 100.0 * (len(ordenados) - 1))))
+    return ordenados[indice]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("destino", help="host ou host:porta da estação")
+    parser.add_argument("-n", type=int, default=200, help="requisições (padrão 200)")
+    parser.add_argument("--caminho", default="/json")
+    parser.add_argument("--rotulo", default="", help="identificação da linha de resultado")
+    parser.add_argument("--csv", help="grava o tempo de cada requisição")
+    parser.add_argument("--timeout", type=float, default=5.0)
+    args = parser.parse_args()
+
+    host, _, porta = args.destino.partition(":")
+    porta = int(porta) if porta else 80
+
+    tempos, falhas = [], 0
+    for _ in range(args.n):
+        try:
+            tempos.append(medir(host, porta, args.caminho, args.timeout))
+        except (OSError, RuntimeError, http.client.HTTPException) as erro:
+            falhas += 1
+            print("falha: %s" % erro, file=sys.stderr)
+    if not tempos:
+        sys.exit("http_bench.py: nenhuma requisição concluída")
+
+    if args.csv:
+        with open(args.csv, "w", encoding="utf-8") as f:
+            f.write("ms\n")
+            f.writelines("%.3f\n" % t for t in tempos)
+
+    ordenados = sorted(tempos)
+    print("%s n=%d falhas=%d min=%.2f mediana=%.2f p95=%.2f p99=%.2f max=%.2f ms" % (
+        args.rotulo or args.destino, len(tempos), falhas, ordenados[0], statistics.median(ordenados),
+        percentil(ordenados, 95), percentil(ordenados, 99), ordenados[-1]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,175 @@
+/*
+ * Micro-benchmark da representação em centésimos inteiros: compara, por valor, a
+ * conversão do AHT20 (aht20_parse contra a conta antiga em float com literais double)
+ * e a formatação com uma casa decimal (ponto_fixo_formatar contra snprintf "%.1f").
+ *
+ * No RP2040 conta ciclos pelo SysTick (clk_sys), com o printf do SDK compilado com
+ * suporte a float só neste alvo; no host usa o TSC em x86 ou, em outras arquiteturas,
+ * nanossegundos. A diferença de flash do firmware sai de tools/ram_report.py --comparar.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "aht20.h"
+#include "ponto_fixo.h"
+
+#define REPETICOES 50
+#define VALORES 16
+
+#if PICO_ON_DEVICE
+#include "hardware/structs/systick.h"
+#define UNIDADE "ciclos"
+
+static void iniciar_contador(void)
+{
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5; // Habilitado, fonte = clock do processador
+}
+
+// SysTick decrementa e tem 24 bits: a diferença é tomada módulo 2^24
+static uint32_t ler_contador(void)
+{
+    return 0x00FFFFFF - systick_hw->cvr;
+}
+
+static uint32_t diferenca(uint32_t inicio, uint32_t fim)
+{
+    return (fim - inicio) & 0x00FFFFFF;
+}
+#else
+static void iniciar_contador(void)
+{
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define UNIDADE "ciclos TSC"
+static uint64_t ler_contador(void)
+{
+    return __rdtsc();
+}
+#else
+#include <time.h>
+#define UNIDADE "ns"
+static uint64_t ler_contador(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
+
+static uint32_t diferenca(uint64_t inicio, uint64_t fim)
+{
+    return (uint32_t)(fim - inicio);
+}
+#endif
+
+static uint8_t respostas[VALORES][AHT20_TAMANHO_RESPOSTA];
+static int32_t centesimos[VALORES];
+static float reais[VALORES];
+static volatile int32_t sumidouro; // Impede o compilador de descartar os resultados
+
+// Referência: a conversão antiga de aht20_read, em float com literais double
+static void converter_float(const uint8_t buffer[AHT20_TAMANHO_RESPOSTA], float *temp, float *umid)
+{
+    uint32_t raw_humidity = ((uint32_t)buffer[1] << 12) | ((uint32_t)buffer[2] << 4) | (buffer[3] >> 4);
+    *umid = (float)raw_humidity * 100.0 / 1048576.0;
+    uint32_t raw_temp = ((uint32_t)(buffer[3] & 0x0F) << 16) | ((uint32_t)buffer[4] << 8) | buffer[5];
+    *temp = ((float)raw_temp * 200.0 / 1048576.0) - 50.0;
+}
+
+static void conversao_float(void)
+{
+    for (int i = 0; i < VALORES; i++)
+    {
+        float temp, umid;
+        converter_float(respostas[i], &temp, &umid);
+        sumidouro += (int32_t)(temp + umid);
+    }
+}
+
+static void conversao_inteira(void)
+{
+    for (int i = 0; i < VALORES; i++)
+    {
+        AHT20_Data dados;
+        aht20_parse(respostas[i], &dados);
+        sumidouro += dados.temperature + dados.humidity;
+    }
+}
+
+static void formatacao_float(void)
+{
+    char texto[PONTO_FIXO_TEXTO_MAX];
+    for (int i = 0; i < VALORES; i++)
+        sumidouro += snprintf(texto, sizeof(texto), "%.1f", reais[i]);
+}
+
+static void formatacao_inteira(void)
+{
+    char texto[PONTO_FIXO_TEXTO_MAX];
+    for (int i = 0; i < VALORES; i++)
+        sumidouro += ponto_fixo_formatar(texto, centesimos[i]);
+}
+
+// Melhor tempo por valor entre as repetições
+static uint32_t medir(void (*rodar)(void))
+{
+    uint32_t melhor = UINT32_MAX;
+    for (int i = 0; i < REPETICOES; i++)
+    {
+        uint32_t ciclos;
+        {
+            __typeof__(ler_contador()) inicio = ler_contador();
+            rodar();
+            ciclos = diferenca(inicio, ler_contador());
+        }
+        if (ciclos < melhor)
+            melhor = ciclos;
+    }
+    return melhor / VALORES;
+}
+
+int main(void)
+{
+    stdio_init_all();
+    iniciar_contador();
+
+    // Leituras espalhadas pela faixa dos 20 bits e valores típicos da estação (-12,3 a 1013,2)
+    for (int i = 0; i < VALORES; i++)
+    {
+        uint32_t raw = (uint32_t)i * 65521u + 12345u;
+        respostas[i][1] = (uint8_t)(raw >> 12);
+        respostas[i][2] = (uint8_t)(raw >> 4);
+        respostas[i][3] = (uint8_t)((raw << 4) | (raw >> 16));
+        respostas[i][4] = (uint8_t)(raw >> 8);
+        respostas[i][5] = (uint8_t)raw;
+        centesimos[i] = -1230 + i * 6829;
+        reais[i] = centesimos[i] / 100.0f;
+    }
+
+    do
+    {
+        uint32_t conv_float = medir(conversao_float);
+        uint32_t conv_inteira = medir(conversao_inteira);
+        uint32_t fmt_float = medir(formatacao_float);
+        uint32_t fmt_inteira = medir(formatacao_inteira);
+        printf("[BENCH] Por valor (melhor de %d), em %s:\n", REPETICOES, UNIDADE);
+        printf("[BENCH]   conversão AHT20 float:   %lu\n", (unsigned long)conv_float);
+        printf("[BENCH]   conversão AHT20 inteira: %lu (%.1fx)\n", (unsigned long)conv_inteira,
+               (double)conv_float / conv_inteira);
+        printf("[BENCH]   snprintf \"%%.1f\":         %lu\n", (unsigned long)fmt_float);
+        printf("[BENCH]   ponto_fixo_formatar:     %lu (%.1fx)\n", (unsigned long)fmt_inteira,
+               (double)fmt_float / fmt_inteira);
+#if PICO_ON_DEVICE
+        sleep_ms(2000);
+    } while (true);
+#else
+    } while (false);
+#endif
+    return 0;
+}
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""Lista os maiores consumidores de RAM estática (.data e .bss) de um ELF.
+
+Roda ao fim do link do firmware, logo após o resumo por região que o linker imprime
+com --print-memory-usage. No modo WEATHER_STATION_ESTATICO as pilhas, TCBs e estados
+de conexão aparecem aqui (pilhas_tarefas, tcbs_tarefas, conexoes), e a soma cobre
+toda a memória que o firmware usa fora do heap do newlib e da pilha de main.
+
+Com --comparar, mede a diferença de flash e RAM em relação a outro build do mesmo
+firmware (totais text/data/bss como os do arm-none-eabi-size e os símbolos que mais
+mudaram, código incluído). Ex.: a troca de float por centésimos inteiros:
+
+  git checkout 443b779~1 && cmake --build build && cp build/weather_station.elf antes.elf
+  git checkout 443b779 && cmake --build build
+  ram_report.py arm-none-eabi-nm build/weather_station.elf --comparar antes.elf
+
+Uso: ram_report.py <nm> <elf> [--top N] [--comparar <elf_anterior>]
+"""
+
+import argparse
+import struct
+import subprocess
+import sys
+
+SHF_WRITE = 0x1
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+
+def simbolos(nm, elf, tipos):
+    saida = subprocess.run([nm, "--size-sort", "--print-size", "--radix=d", elf],
+                           check=True, capture_output=True, text=True).stdout
+    encontrados = []
+    for linha in saida.splitlines():
+        campos = linha.split()
+        # endereço, tamanho, tipo, nome; b/B = .bss, d/D = .data, t/T = .text, r/R = .rodata
+        if len(campos) == 4 and campos[2] in tipos:
+            encontrados.append((int(campos[1]), campos[2].lower(), campos[3]))
+    return encontrados
+
+
+def simbolos_ram(nm, elf):
+    return simbolos(nm, elf, "bBdD")
+
+
+def totais_secoes(elf):
+    """text, data e bss pelas seções alocadas, com a mesma regra do size (formato Berkeley)."""
+    with open(elf, "rb") as f:
+        dados = f.read()
+    if dados[:4] != b"\x7fELF":
+        raise OSError("%s não é um ELF" % elf)
+    bits64 = dados[4] == 2
+    ordem = "<" if dados[5] == 1 else ">"
+    if bits64:
+        shoff, = struct.unpack_from(ordem + "Q", dados, 0x28)
+        shentsize, shnum = struct.unpack_from(ordem + "HH", dados, 0x3A)
+    else:
+        shoff, = struct.unpack_from(ordem + "I", dados, 0x20)
+        shentsize, shnum = struct.unpack_from(ordem + "HH", dados, 0x2E)
+
+    text = data = bss = 0
+    for i in range(shnum):
+        base = shoff + i * shentsize
+        if bits64:
+            tipo, flags = struct.unpack_from(ordem + "IQ", dados, base + 4)
+            tamanho, = struct.unpack_from(ordem + "Q", dados, base + 32)
+        else:
+            tipo, flags = struct.unpack_from(ordem + "II", dados, base + 4)
+            tamanho, = struct.unpack_from(ordem + "I", dados, base + 20)
+        if not flags & SHF_ALLOC:
+            continue
+        if tipo == SHT_NOBITS:
+            bss += tamanho
+        elif flags & SHF_WRITE:
+            data += tamanho
+        else:
+            text += tamanho
+    return text, data, bss
+
+
+def comparar(nm, elf, anterior, top):
+    novo = totais_secoes(elf)
+    antigo = totais_secoes(anterior)
+    # Flash guarda o código, as constantes e a imagem inicial de .data
+    print("[TAMANHO] %-6s %10s %10s %10s" % ("", "anterior", "atual", "diferença"))
+    for nome, a, n in (("text", antigo[0], novo[0]), ("data", antigo[1], novo[1]), ("bss", antigo[2], novo[2]),
+                       ("flash", antigo[0] + antigo[1], novo[0] + novo[1]), ("ram", antigo[1] + antigo[2], novo[1] + novo[2])):
+        print("[TAMANHO] %-6s %10d %10d %+10d" % (nome, a, n, n - a))
+
+    tipos = "bBdDtTrRwW"
+    tamanhos_antigos = {nome: t for t, _, nome in simbolos(nm, anterior, tipos)}
+    tamanhos_novos = {nome: t for t, _, nome in simbolos(nm, elf, tipos)}
+    diferencas = []
+    for nome in set(tamanhos_antigos) | set(tamanhos_novos):
+        d = tamanhos_novos.get(nome, 0) - tamanhos_antigos.get(nome, 0)
+        if d:
+            diferencas.append((abs(d), d, nome))
+    for _, d, nome in sorted(diferencas, reverse=True)[:top]:
+        print("[TAMANHO] %+8d  %s" % (d, nome))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("nm")
+    parser.add_argument("elf")
+    parser.add_argument("--top", type=int, default=20, help="símbolos listados (padrão 20)")
+    parser.add_argument("--comparar", metavar="ELF", help="build anterior para a diferença de flash e RAM")
+    args = parser.parse_args()
+
+    try:
+        if args.comparar:
+            comparar(args.nm, args.elf, args.comparar, args.top)
+            return
+        lista = simbolos_ram(args.nm, args.elf)
+    except (OSError, subprocess.CalledProcessError) as erro:
+        sys.exit("ram_report.py: %s" % erro)
+
+    total_data = sum(t for t, tipo, _ in lista if tipo == "d")
+    total_bss = sum(t for t, tipo, _ in lista if tipo == "b")
+    print("[RAM] .data %d bytes, .bss %d bytes, total %d bytes em %d símbolos" % (
+        total_data, total_bss, total_data + total_bss, len(lista)))
+    for tamanho, tipo, nome in sorted(lista, reverse=True)[:args.top]:
+        print("[RAM] %8d  .%-4s  %s" % (tamanho, "data" if tipo == "d" else "bss", nome))
+
+
+if __name__ == "__main__":
+    main()
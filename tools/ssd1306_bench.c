@@ -0,0 +1,165 @@
+/*
+ * Micro-benchmark da camada de desenho do SSD1306 (sem I2C): mede o redesenho de
+ * uma tela cheia como o de atualizar_display, com as primitivas da biblioteca e com
+ * uma referência pixel a pixel equivalente ao driver antigo.
+ *
+ * No RP2040 conta ciclos pelo SysTick (clk_sys); no host usa o TSC em x86 ou, em
+ * outras arquiteturas, nanossegundos. Só o desenho é medido: ssd1306_send_data não é
+ * chamada e o display não precisa estar conectado.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "ssd1306.h"
+#include "font.h"
+
+#define REPETICOES 200
+
+#if PICO_ON_DEVICE
+#include "hardware/structs/systick.h"
+#define UNIDADE "ciclos"
+
+static void iniciar_contador(void)
+{
+    systick_hw->rvr = 0x00FFFFFF;
+    systick_hw->cvr = 0;
+    systick_hw->csr = 0x5; // Habilitado, fonte = clock do processador
+}
+
+// SysTick decrementa e tem 24 bits: a diferença é tomada módulo 2^24
+static uint32_t ler_contador(void)
+{
+    return 0x00FFFFFF - systick_hw->cvr;
+}
+
+static uint32_t diferenca(uint32_t inicio, uint32_t fim)
+{
+    return (fim - inicio) & 0x00FFFFFF;
+}
+#else
+static void iniciar_contador(void)
+{
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define UNIDADE "ciclos TSC"
+static uint64_t ler_contador(void)
+{
+    return __rdtsc();
+}
+#else
+#include <time.h>
+#define UNIDADE "ns"
+static uint64_t ler_contador(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
+
+static uint32_t diferenca(uint64_t inicio, uint64_t fim)
+{
+    return (uint32_t)(fim - inicio);
+}
+
+// O driver chama i2c_write_blocking só em ssd1306_send_data, que não é usada aqui
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop)
+{
+    (void)i2c;
+    (void)addr;
+    (void)src;
+    (void)nostop;
+    return (int)len;
+}
+#endif
+
+static const char *linhas[4] = {"Temp: 24.5 C   ", "Umid: 55.0 %   ", "Press: 1006.5 hPa             ", "WiFi: OK       "};
+
+// Referência: o algoritmo do driver antigo, um ssd1306_pixel por pixel
+static void desenhar_char_pixel(ssd1306_t *ssd, char c, uint8_t x, uint8_t y)
+{
+    uint16_t index = ((uint8_t)c >= 32 && (uint8_t)c <= 139) ? ((uint8_t)c - 32) * 8 : 0;
+    for (uint8_t row = 0; row < 8; ++row)
+    {
+        uint8_t line = font[index + (7 - row)];
+        for (uint8_t col = 0; col < 8; ++col)
+            ssd1306_pixel(ssd, x + col, y + row, (line & (1 << (7 - col))) != 0);
+    }
+}
+
+static void redesenhar_pixel(ssd1306_t *ssd)
+{
+    for (uint8_t y = 0; y < ssd->height; ++y)
+        for (uint8_t x = 0; x < ssd->width; ++x)
+            ssd1306_pixel(ssd, x, y, false);
+    for (int l = 0; l < 4; l++)
+    {
+        uint8_t x = 0, y = l * 16;
+        for (const char *s = linhas[l]; *s; s++)
+        {
+            desenhar_char_pixel(ssd, *s, x, y);
+            x += 8;
+            if (x + 8 >= ssd->width)
+            {
+                x = 0;
+                y += 8;
+            }
+        }
+    }
+}
+
+static void redesenhar_primitivas(ssd1306_t *ssd)
+{
+    ssd1306_fill(ssd, false);
+    for (int l = 0; l < 4; l++)
+        ssd1306_draw_string(ssd, linhas[l], 0, l * 16);
+}
+
+static uint32_t medir(ssd1306_t *ssd, void (*redesenhar)(ssd1306_t *))
+{
+    uint32_t melhor = UINT32_MAX;
+    for (int i = 0; i < REPETICOES; i++)
+    {
+        ssd1306_invalidate(ssd);
+        // Alterna o conteúdo para cada redesenho mudar todos os bytes
+        ssd1306_fill(ssd, true);
+        uint32_t ciclos;
+        {
+            __typeof__(ler_contador()) inicio = ler_contador();
+            redesenhar(ssd);
+            ciclos = diferenca(inicio, ler_contador());
+        }
+        if (ciclos < melhor)
+            melhor = ciclos;
+    }
+    return melhor;
+}
+
+int main(void)
+{
+    stdio_init_all();
+    iniciar_contador();
+
+    static uint64_t colunas[WIDTH];
+    static uint8_t envio[SSD1306_TX_BYTES(WIDTH, HEIGHT)];
+    ssd1306_t ssd;
+    ssd1306_init(&ssd, WIDTH, HEIGHT, false, 0x3C, NULL, colunas, envio);
+
+    do
+    {
+        uint32_t pixel = medir(&ssd, redesenhar_pixel);
+        uint32_t primitivas = medir(&ssd, redesenhar_primitivas);
+        printf("[BENCH] Redesenho de tela cheia (melhor de %d), em %s:\n", REPETICOES, UNIDADE);
+        printf("[BENCH]   pixel a pixel: %lu\n", (unsigned long)pixel);
+        printf("[BENCH]   primitivas:    %lu (%.1fx)\n", (unsigned long)primitivas, (double)pixel / primitivas);
+#if PICO_ON_DEVICE
+        sleep_ms(2000);
+    } while (true);
+#else
+    } while (false);
+#endif
+    return 0;
+}
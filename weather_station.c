@@ -9,9 +9,13 @@
  */
 
 #include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <ctype.h>
+#include <strings.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
 #include "hardware/gpio.h"
@@ -20,13 +24,19 @@
 #include "lwip/pbuf.h"
 #include "lwip/tcp.h"
 #include "lwip/netif.h"
+#include "lwip/stats.h"
 #include "FreeRTOS.h"
 #include "task.h"
-#include "semphr.h"
 #include "lib/ssd1306.h"
+#include "lib/i2c_dma.h"
 #include "lib/aht20.h"
 #include "lib/bmp280.h"
+#include "lib/http_parser.h"
+#include "lib/ponto_fixo.h"
+#include "lib/pubsub.h"
+#include "lib/websocket.h"
 #include "pico/bootrom.h"
+#include "html_page.h" // Gerado em build a partir de web/index.html
 
 // ===================== DEFINIÇÕES DE HARDWARE =====================
 #define I2C_PORT_SENSORES i2c0
@@ -37,6 +47,8 @@
 #define I2C_DISP_SDA 14
 #define I2C_DISP_SCL 15
 #define DISPLAY_ADDRESS 0x3C
+#define DISPLAY_DMA_PALAVRAS 1088  // Uma tela cheia (1025 bytes) mais os comandos de janela
+#define SENSORES_DMA_PALAVRAS 32   // Disparos do BMP280 e do AHT20 + leitura do BMP280 (ou do AHT20)
 
 #define LED_RED_PIN 13
 #define LED_GREEN_PIN 11
@@ -56,64 +68,171 @@
 #define WIFI_SSID "Minha Internet"
 #define WIFI_PASS "minhasenha157"
 #define TCP_TIMEOUT_MS 10000
-#define TCP_CHUNK_SIZE 512
-#define MAX_REQUEST_SIZE 1024
+#define HTTP_KEEPALIVE_TIMEOUT_MS 5000
+#define HTTP_PIPELINE_MIN_SNDBUF 768 // Espaço livre mínimo para montar a próxima resposta em pipeline
 #define WIFI_RECONNECT_INTERVAL_MS 5000
-
-// Limites padrão saudáveis para humanos
-#define TEMP_MIN_DEFAULT 15.0f
-#define TEMP_MAX_DEFAULT 30.0f
-#define HUM_MIN_DEFAULT 30.0f
-#define HUM_MAX_DEFAULT 70.0f
-#define PRESS_MIN_DEFAULT 950.0f
-#define PRESS_MAX_DEFAULT 1050.0f
+#define HISTORICO_INTERVALO_MS 10000 // Uma amostra guardada no histórico a cada 10 s
+#define HISTORICO_CAPACIDADE 1440    // 4 h de histórico (16 bytes por amostra)
+#define HISTORICO_MAX_PADRAO 50      // Pontos exibidos nos gráficos do dashboard
+#define CORPO_GERADO_MAX 512         // Maior pedaço de corpo gerado sob demanda por escrita
+#define HTTP_CABECALHO_MAX 384       // Cabeçalho mais longo: status + CORS + Keep-Alive + extras
+#define HTTP_TAMANHO_INDEFINIDO ((size_t)-1)
+#define STREAM_MAX_ASSINANTES 3      // SSE + WebSocket; deixa ao menos um PCB livre para requisições comuns
+#define SSE_RETRY_MS 3000            // Intervalo de reconexão sugerido ao EventSource
+#define WS_FILA_MAX 1024             // Frames de resposta ainda não entregues ao lwIP, por conexão
+#define WS_RESPOSTA_MAX 832          // Maior conjunto de frames gerado por uma mensagem (cfg + config)
+#define CFG_RESPOSTA_MAX 512         // JSON de resultado de POST /cfg e da mensagem cfg do WebSocket
+#define CONEXAO_RASCUNHO 1536        // Rascunho por conexão para montar respostas (ver rascunho_reservar)
+#define STATS_MAX_TAREFAS 12         // Tarefas listadas em /stats: as da aplicação, idle e timers do kernel
+#define STATS_JSON_MAX 2048
+#define STATS_PERIODO_MS 1000        // Intervalo entre as amostras de tarefas servidas por /stats
+
+// Telemetria binária (GET /bin ou /json com Accept: application/octet-stream), little-endian:
+//  0 u8  versão            1 u8  tamanho do registro (bytes)
+//  2 i16 temperatura AHT20 em 0,01 °C
+//  4 u16 umidade AHT20 em 0,01 %
+//  6 u16 pressão BMP280 em 0,1 hPa
+//  8 u32 número de sequência da leitura
+// 12 u32 instante da leitura em ms desde o boot
+#define TELEMETRIA_VERSAO 1
+#define TELEMETRIA_TAMANHO 16
+
+// Limites padrão saudáveis para humanos, em centésimos (ver lib/ponto_fixo.h)
+#define TEMP_MIN_DEFAULT 1500    // 15,0 °C
+#define TEMP_MAX_DEFAULT 3000    // 30,0 °C
+#define HUM_MIN_DEFAULT 3000     // 30,0 %
+#define HUM_MAX_DEFAULT 7000     // 70,0 %
+#define PRESS_MIN_DEFAULT 95000  // 950,0 hPa
+#define PRESS_MAX_DEFAULT 105000 // 1050,0 hPa
 
 // ===================== ESTRUTURAS DE DADOS =====================
+// Valores em centésimos de °C, % e hPa (int32, sem ponto flutuante no caminho da
+// leitura até o JSON; o texto sai por ponto_fixo_formatar)
 typedef struct
 {
-    float temp_aht20;
-    float hum_aht20;
-    float press_bmp280;
+    int32_t temp_aht20;
+    int32_t hum_aht20;
+    int32_t press_bmp280;
 } sensor_data_t;
 
+// Limites e offsets nas mesmas unidades de sensor_data_t
 typedef struct
 {
-    float temp_min, temp_max;
-    float hum_min, hum_max;
-    float press_min, press_max;
-    float temp_offset, hum_offset, press_offset;
+    int32_t temp_min, temp_max;
+    int32_t hum_min, hum_max;
+    int32_t press_min, press_max;
+    int32_t temp_offset, hum_offset, press_offset;
+    uint8_t bmp280_perfil;      // bmp280_profile_t; aplicado pela tarefa de leitura
 } config_limits_t;
 
 typedef struct
+{
+    uint32_t t_ms;              // Instante da leitura, em ms desde o boot
+    sensor_data_t dados;
+} amostra_historico_t;
+
+typedef struct
+{
+    sensor_data_t dados;
+    uint32_t seq;               // Leituras concluídas desde o boot
+    uint32_t t_ms;              // Instante da leitura, em ms desde o boot
+    uint64_t t_us;              // Disparo dos sensores (time_us_64, monotônico)
+    uint32_t latencia_us;       // Do disparo até a leitura pronta para publicação
+    uint32_t intervalo_us;      // Desde o disparo da leitura anterior (0 na primeira)
+} leitura_t;
+
+// sensor_data_t em texto com uma casa decimal, para JSON, display e log
+typedef struct
+{
+    char temp[PONTO_FIXO_TEXTO_MAX];
+    char hum[PONTO_FIXO_TEXTO_MAX];
+    char press[PONTO_FIXO_TEXTO_MAX];
+} sensor_texto_t;
+
+typedef struct conn_state
 {
     struct tcp_pcb *pcb;
     absolute_time_t timeout;
     bool response_sent;
-    const char *remaining_data;
+    const char *remaining_data; // Corpo estático ainda não enfileirado (referenciado sem cópia)
     size_t remaining_len;
+    bool copiar_corpo;          // remaining_data aponta para um buffer reutilizável: enfileira com cópia
+    uint32_t bytes_queued;      // Total enfileirado no lwIP (cabeçalho + corpo)
+    uint32_t bytes_acked;       // Total confirmado pelo cliente
+    uint16_t ack_count;         // Callbacks de sent recebidos
+    bool keep_alive;            // Mantém a conexão aberta após a resposta atual
+    bool in_callback;           // Callback em andamento: a vaga não é reocupada antes de ele retornar
+    bool fin_recebido;          // Cliente encerrou o envio; fecha ao concluir as respostas pendentes
+    struct pbuf *pendente;      // Bytes recebidos ainda não consumidos pelo parser
+    union
+    {
+        http_parser_t parser;   // Requisição em andamento, montada incrementalmente
+        ws_parser_t ws_parser;  // Após o upgrade para WebSocket
+    };
+
+    // Corpo gerado sob demanda (ex.: /history), produzido conforme a janela de envio libera.
+    // O gerador devolve quantos bytes escreveu em buf e sinaliza *fim na última parte.
+    size_t (*gerador)(struct conn_state *state, char *buf, size_t max, bool *fim);
+    bool chunked;               // Transfer-Encoding: chunked; em HTTP/1.0 o fechamento delimita o corpo
+    uint32_t hist_cursor;       // Próxima amostra do histórico a enviar
+    uint32_t hist_fim;          // Total de amostras no instante da requisição
+    uint32_t hist_enviadas;
+    uint8_t hist_fase;          // 0: abertura do JSON, 1: amostras, 2: concluído
+    bool sse;                   // Assinante de /events: o corpo só termina quando a conexão fecha
+    bool sse_iniciado;
+    uint32_t sse_seq;           // Última leitura enviada ao assinante
+    bool ws;                    // Conexão promovida a WebSocket (GET /ws)
+    bool ws_fechando;           // Frame de fechamento enfileirado: fecha após entregá-lo
+    uint16_t ws_fila_len;
+    uint8_t ws_fila[WS_FILA_MAX]; // Respostas (pong, cfg, close) aguardando espaço na janela de envio
+    ip_addr_t remoto;           // Endereço do cliente, ainda válido depois que o lwIP libera o PCB
+    uint16_t rascunho_usado;
+    char rascunho[CONEXAO_RASCUNHO]; // Último campo: webserver_accept zera só o que vem antes
 } conn_state_t;
 
 // ===================== VARIÁVEIS GLOBAIS =====================
 ssd1306_t display;
-sensor_data_t sensor_data;
-config_limits_t config = {
+static i2c_dma_t barramento_display;
+static uint16_t palavras_display[DISPLAY_DMA_PALAVRAS];
+static uint64_t colunas_display[WIDTH];
+static uint8_t envio_display[SSD1306_TX_BYTES(WIDTH, HEIGHT)];
+static i2c_dma_t barramento_sensores;
+static uint16_t palavras_sensores[SENSORES_DMA_PALAVRAS];
+static config_limits_t config = {
     .temp_min = TEMP_MIN_DEFAULT, .temp_max = TEMP_MAX_DEFAULT,
     .hum_min = HUM_MIN_DEFAULT, .hum_max = HUM_MAX_DEFAULT,
     .press_min = PRESS_MIN_DEFAULT, .press_max = PRESS_MAX_DEFAULT,
-    .temp_offset = 0, .hum_offset = 0, .press_offset = 0
+    .temp_offset = 0, .hum_offset = 0, .press_offset = 0,
+    .bmp280_perfil = BMP280_PROFILE_STANDARD
 };
-SemaphoreHandle_t mutex_sensor;
-SemaphoreHandle_t mutex_config;
 volatile bool alert_active = false;
 volatile bool wifi_connected = false;
 volatile bool log_medicoes = true;
+static TaskHandle_t tarefa_botoes_handle = NULL;
+static volatile uint32_t botoes_pendentes = 0; // Bit n: GPIO n pressionado, aguardando a tarefa_botoes
 
+// Vagas de conexão alocadas na compilação. A vaga está ativa enquanto tem PCB e só
+// pode ser reocupada quando, além disso, nenhum callback dela está em andamento: não
+// há free a esquecer nem a repetir, então fechar por timeout, por erro do lwIP ou
+// pelo cliente, em qualquer ordem, sempre devolve a vaga.
 #define MAX_CONNECTIONS 4
-conn_state_t *active_connections[MAX_CONNECTIONS] = {NULL};
+static conn_state_t conexoes[MAX_CONNECTIONS];
+
+// Última leitura em dois buffers: o escritor preenche o que não está publicado e só
+// então avança leitura_versao, cuja paridade indica o buffer atual
+static leitura_t leituras[2];
+static uint32_t leitura_versao = 0;
+
+// Histórico circular: historico_total amostras publicadas; historico_escrita é
+// incrementado antes de cada gravação para que leitores detectem sobrescritas
+static amostra_historico_t historico[HISTORICO_CAPACIDADE];
+static uint32_t historico_total = 0;
+static uint32_t historico_escrita = 0;
 
 // ===================== PROTÓTIPOS =====================
 void inicializar_hardware(void);
 void inicializar_display(void);
+static int display_escrever(void *contexto, uint8_t endereco, const uint8_t *dados, size_t len);
 void inicializar_leds(void);
 void inicializar_buzzer(void);
 void inicializar_botoes(void);
@@ -127,178 +246,136 @@ void tarefa_display(void *param);
 void tarefa_timeout(void *param);
 void manipulador_interrupcao_gpio(uint gpio, uint32_t eventos);
 void tratar_botao(uint btn);
+void tarefa_botoes(void *param);
 static err_t webserver_sent(void *arg, struct tcp_pcb *tpcb, u16_t len);
 static err_t webserver_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err);
 static err_t webserver_accept(void *arg, struct tcp_pcb *newpcb, err_t err);
 void send_http_response(struct tcp_pcb *tpcb, const char *header, const char *body, conn_state_t *state);
+void send_http_response_static(struct tcp_pcb *tpcb, const char *header, const char *body, size_t body_len, conn_state_t *state);
 void close_connection(conn_state_t *state);
+static void eventos_notificar(void);
+static void historico_adicionar(const sensor_data_t *dados, uint32_t t_ms);
+static void leitura_publicar(const sensor_data_t *dados, uint64_t t_us, uint32_t latencia_us);
+static void leitura_obter(leitura_t *leitura);
+static void sensor_formatar(const sensor_data_t *dados, sensor_texto_t *texto);
+static void processar_requisicoes(struct tcp_pcb *tpcb, conn_state_t *state);
+
+// ===================== NÚCLEOS =====================
+// Com WEATHER_STATION_SMP (configNUM_CORES 2) a rede fica no núcleo 0, onde main chama
+// cyw43_arch_init e onde, portanto, rodam a interrupção do CYW43 e os callbacks do
+// lwIP; sensores, display, alerta e botões ficam no núcleo 1. O estado compartilhado
+// entre os dois lados já é acessado sem trava (leitura_publicar, historico_adicionar:
+// contadores atômicos) ou em seções críticas, que no SMP valem para os dois núcleos
+// (config: config_ler/config_gravar).
+#define NUCLEO_REDE 0
+#define NUCLEO_APLICACAO 1
+
+// ===================== TAREFAS =====================
+// Pilhas em palavras de StackType_t
+#define PILHA_SENSORES 1024
+#define PILHA_WEBSERVER 2048
+#define PILHA_ALERTA 1024
+#define PILHA_DISPLAY 1024
+#define PILHA_TIMEOUT 512
+#define PILHA_BOTOES 512
+#define TOTAL_TAREFAS 6
+
+#if configSUPPORT_STATIC_ALLOCATION
+// Com WEATHER_STATION_ESTATICO as pilhas saem de um único vetor global e os TCBs de
+// outro, ambos dimensionados na compilação e somados no relatório de RAM do link
+static StackType_t pilhas_tarefas[PILHA_SENSORES + PILHA_WEBSERVER + PILHA_ALERTA + PILHA_DISPLAY +
+                                  PILHA_TIMEOUT + PILHA_BOTOES];
+static StaticTask_t tcbs_tarefas[TOTAL_TAREFAS];
+static size_t pilhas_usadas = 0;
+static UBaseType_t tarefas_criadas = 0;
+#endif
+
+static void criar_tarefa(TaskFunction_t funcao, const char *nome, configSTACK_DEPTH_TYPE pilha,
+                         UBaseType_t prioridade, TaskHandle_t *handle, UBaseType_t nucleo)
+{
+    TaskHandle_t tarefa = NULL;
+#if configSUPPORT_STATIC_ALLOCATION
+    // Cada tarefa recebe o próximo trecho de pilhas_tarefas e o próximo TCB
+    if (tarefas_criadas < TOTAL_TAREFAS &&
+        pilhas_usadas + pilha <= sizeof(pilhas_tarefas) / sizeof(pilhas_tarefas[0]))
+    {
+        tarefa = xTaskCreateStatic(funcao, nome, pilha, NULL, prioridade, &pilhas_tarefas[pilhas_usadas],
+                                   &tcbs_tarefas[tarefas_criadas]);
+        pilhas_usadas += pilha;
+        tarefas_criadas++;
+    }
+#else
+    if (xTaskCreate(funcao, nome, pilha, NULL, prioridade, &tarefa) != pdPASS)
+        tarefa = NULL;
+#endif
+    if (!tarefa)
+    {
+        printf("[ERRO] Falha ao criar a tarefa %s\n", nome);
+        return;
+    }
+#if configNUM_CORES > 1
+    vTaskCoreAffinitySet(tarefa, 1u << nucleo);
+#else
+    (void)nucleo;
+#endif
+    if (handle)
+        *handle = tarefa;
+}
+
+#if configSUPPORT_STATIC_ALLOCATION
+// Memória das tarefas do próprio kernel (idle e timers), que no modo estático também
+// é fornecida pela aplicação
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+                                   configSTACK_DEPTH_TYPE *puxIdleTaskStackSize)
+{
+    static StaticTask_t tcb_idle;
+    static StackType_t pilha_idle[configMINIMAL_STACK_SIZE];
+    *ppxIdleTaskTCBBuffer = &tcb_idle;
+    *ppxIdleTaskStackBuffer = pilha_idle;
+    *puxIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+#if configNUM_CORES > 1
+// Idle dos demais núcleos no SMP
+void vApplicationGetPassiveIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+                                          configSTACK_DEPTH_TYPE *puxIdleTaskStackSize, BaseType_t xPassiveIdleTaskIndex)
+{
+    static StaticTask_t tcbs_idle_passiva[configNUM_CORES - 1];
+    static StackType_t pilhas_idle_passiva[configNUM_CORES - 1][configMINIMAL_STACK_SIZE];
+    *ppxIdleTaskTCBBuffer = &tcbs_idle_passiva[xPassiveIdleTaskIndex];
+    *ppxIdleTaskStackBuffer = pilhas_idle_passiva[xPassiveIdleTaskIndex];
+    *puxIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+#endif
 
-// ===================== HTML/CSS/JS EMBUTIDO =====================
-const char *html_page =
-    "<!DOCTYPE html><html lang='pt'><head><meta charset='UTF-8'><meta name='viewport' content='width=device-width,initial-scale=1'><title>Estação BitDogLab</title>"
-    "<style>"
-    "body{font-family:Arial,sans-serif;margin:0;padding:20px;background:#222;color:#eee;display:flex;flex-direction:column;align-items:center;min-height:100vh}"
-    "h1{font-size:1.8em;margin-bottom:20px;text-align:center}"
-    "#dados{font-size:1.2em;margin:20px 0;padding:10px;background:#333;border-radius:5px;width:100%;max-width:400px;text-align:center}"
-    ".graficos{display:flex;justify-content:center;gap:20px;flex-wrap:wrap}"
-    ".grafico-container{width:300px;margin:10px 0}"
-    ".grafico-container canvas{border:1px solid #555}"
-    ".grafico-container h3{font-size:1.2em;margin:5px 0;color:#4CAF50;text-align:center}"
-    ".grafico-container .legend{font-size:0.9em;color:#bbb;text-align:center}"
-    "#cfg{width:100%;max-width:600px;background:#333;padding:20px;border-radius:5px;display:grid;gap:15px}"
-    ".title-container{text-align:center}"
-    ".pair-container{display:grid;grid-template-columns:1fr 1fr;gap:10px;align-items:center}"
-    ".offset-container{display:grid;grid-template-columns:150px 100px 100px;gap:10px;align-items:center}"
-    ".button-container{display:grid;grid-template-columns:1fr;justify-items:center}"
-    ".status-container{text-align:center;font-size:1em;color:#4CAF50}"
-    ".pair-container label,.offset-container label{font-size:1em;color:#eee;text-align:right;min-width:100px}"
-    "input[type=number]{width:100px;padding:5px;border:1px solid #555;border-radius:3px;background:#444;color:#eee;box-sizing:border-box}"
-    ".current-value{font-size:0.9em;color:#4CAF50;text-align:right;width:100px}"
-    "button{padding:8px 16px;background:#4CAF50;border:none;border-radius:3px;color:white;cursor:pointer}"
-    "button:hover{background:#45a049}"
-    "@media(max-width:900px){.graficos{flex-direction:column;align-items:center}.grafico-container{width:100%;max-width:300px}}"
-    "@media(max-width:600px){body{padding:10px}#dados,#cfg{max-width:100%}.pair-container{grid-template-columns:1fr}.offset-container{grid-template-columns:120px 80px 80px}input[type=number]{width:80px}.pair-container label,.offset-container label{min-width:120px}}"
-    "</style></head>"
-    "<body><h1>Estação Meteorológica</h1><div id='dados'>Carregando...</div>"
-    "<div class='graficos'>"
-    "<div class='grafico-container'><h3>Temperatura (°C)</h3><canvas id='grafico-temp' width='300' height='100'></canvas><div id='legend-temp' class='legend'></div></div>"
-    "<div class='grafico-container'><h3>Umidade (%)</h3><canvas id='grafico-hum' width='300' height='100'></canvas><div id='legend-hum' class='legend'></div></div>"
-    "<div class='grafico-container'><h3>Pressão (hPa)</h3><canvas id='grafico-press' width='300' height='100'></canvas><div id='legend-press' class='legend'></div></div>"
-    "</div>"
-    "<form id='cfg'>"
-    "<div class='title-container'><h2>Configuração</h2></div>"
-    "<div class='pair-container'>"
-    "<div><label>Temp Mín (°C):</label><input name='temp_min' type='number' step='0.1' placeholder='15.0'><span class='current-value' id='current-temp-min'></span></div>"
-    "<div><label>Temp Máx (°C):</label><input name='temp_max' type='number' step='0.1' placeholder='30.0'><span class='current-value' id='current-temp-max'></span></div>"
-    "</div>"
-    "<div class='pair-container'>"
-    "<div><label>Umid Mín (%):</label><input name='hum_min' type='number' step='0.1' placeholder='30.0'><span class='current-value' id='current-hum-min'></span></div>"
-    "<div><label>Umid Máx (%):</label><input name='hum_max' type='number' step='0.1' placeholder='70.0'><span class='current-value' id='current-hum-max'></span></div>"
-    "</div>"
-    "<div class='pair-container'>"
-    "<div><label>Press Mín (hPa):</label><input name='press_min' type='number' step='0.1' placeholder='950.0'><span class='current-value' id='current-press-min'></span></div>"
-    "<div><label>Press Máx (hPa):</label><input name='press_max' type='number' step='0.1' placeholder='1050.0'><span class='current-value' id='current-press-max'></span></div>"
-    "</div>"
-    "<div class='offset-container'><h3>Offsets</h3></div>"
-    "<div class='offset-container'><label>Offset Temp (°C):</label><input name='temp_offset' type='number' step='0.1' placeholder='0.0'><span class='current-value' id='current-temp-offset'></span></div>"
-    "<div class='offset-container'><label>Offset Umid (%):</label><input name='hum_offset' type='number' step='0.1' placeholder='0.0'><span class='current-value' id='current-hum-offset'></span></div>"
-    "<div class='offset-container'><label>Offset Press (hPa):</label><input name='press_offset' type='number' step='0.1' placeholder='0.0'><span class='current-value' id='current-press-offset'></span></div>"
-    "<div class='button-container'><button type='submit'>Salvar</button></div>"
-    "<div class='status-container' id='status'></div>"
-    "</form>"
-    "<script>"
-    "let d = []; const dadosEl = document.getElementById('dados'); const statusEl = document.getElementById('status');"
-    "let config = {temp_min: 15, temp_max: 30, hum_min: 30, hum_max: 70, press_min: 950, press_max: 1050, temp_offset: 0, hum_offset: 0, press_offset: 0};"
-    "async function loadConfig() {"
-    "  try {"
-    "    const r = await fetch('/config', { method: 'GET', headers: { 'Accept': 'application/json' } });"
-    "    if (!r.ok) throw new Error(`Erro HTTP ${r.status}: ${r.statusText}`);"
-    "    config = await r.json();"
-    "    document.getElementById('current-temp-min').textContent = `${config.temp_min.toFixed(1)}`;"
-    "    document.getElementById('current-temp-max').textContent = `${config.temp_max.toFixed(1)}`;"
-    "    document.getElementById('current-hum-min').textContent = `${config.hum_min.toFixed(1)}`;"
-    "    document.getElementById('current-hum-max').textContent = `${config.hum_max.toFixed(1)}`;"
-    "    document.getElementById('current-press-min').textContent = `${config.press_min.toFixed(1)}`;"
-    "    document.getElementById('current-press-max').textContent = `${config.press_max.toFixed(1)}`;"
-    "    document.getElementById('current-temp-offset').textContent = `${config.temp_offset.toFixed(1)}`;"
-    "    document.getElementById('current-hum-offset').textContent = `${config.hum_offset.toFixed(1)}`;"
-    "    document.getElementById('current-press-offset').textContent = `${config.press_offset.toFixed(1)}`;"
-    "    document.querySelector('input[name=\"temp_min\"]').value = config.temp_min.toFixed(1);"
-    "    document.querySelector('input[name=\"temp_max\"]').value = config.temp_max.toFixed(1);"
-    "    document.querySelector('input[name=\"hum_min\"]').value = config.hum_min.toFixed(1);"
-    "    document.querySelector('input[name=\"hum_max\"]').value = config.hum_max.toFixed(1);"
-    "    document.querySelector('input[name=\"press_min\"]').value = config.press_min.toFixed(1);"
-    "    document.querySelector('input[name=\"press_max\"]').value = config.press_max.toFixed(1);"
-    "    document.querySelector('input[name=\"temp_offset\"]').value = config.temp_offset.toFixed(1);"
-    "    document.querySelector('input[name=\"hum_offset\"]').value = config.hum_offset.toFixed(1);"
-    "    document.querySelector('input[name=\"press_offset\"]').value = config.press_offset.toFixed(1);"
-    "  } catch (e) {"
-    "    console.error('Erro ao carregar configuração:', e);"
-    "    statusEl.textContent = `Erro ao carregar config: ${e.message}`; statusEl.style.color = '#f44336';"
-    "  }"
-    "}"
-    "async function atualiza() {"
-    "  try {"
-    "    const r = await fetch('/json', { method: 'GET', headers: { 'Accept': 'application/json' } });"
-    "    if (!r.ok) throw new Error(`Erro HTTP ${r.status}: ${r.statusText}`);"
-    "    const j = await r.json();"
-    "    dadosEl.textContent = `Temp: ${j.temp_aht20.toFixed(1)}°C | Umid: ${j.hum_aht20.toFixed(1)}% | Press: ${j.press_bmp280.toFixed(1)}hPa`;"
-    "    d.push(j); if (d.length > 50) d.shift();"
-    "    const drawGraph = (canvasId, dataKey, color, min, max, unit) => {"
-    "      const canvas = document.getElementById(canvasId);"
-    "      const ctx = canvas.getContext('2d');"
-    "      ctx.clearRect(0, 0, canvas.width, canvas.height);"
-    "      const range = max - min; const scale = 80 / range;"
-    "      ctx.strokeStyle = '#555'; ctx.lineWidth = 1;"
-    "      ctx.beginPath(); ctx.moveTo(0, 10); ctx.lineTo(300, 10); ctx.stroke();"
-    "      ctx.beginPath(); ctx.moveTo(0, 90); ctx.lineTo(300, 90); ctx.stroke();"
-    "      ctx.font = '10px Arial'; ctx.fillStyle = '#bbb';"
-    "      ctx.fillText(`${max.toFixed(1)}${unit}`, 5, 15);"
-    "      ctx.fillText(`${min.toFixed(1)}${unit}`, 5, 95);"
-    "      ctx.strokeStyle = color; ctx.lineWidth = 2; ctx.beginPath();"
-    "      for (let i = 0; i < d.length; i++) {"
-    "        const y = 90 - ((d[i][dataKey] - min) * scale);"
-    "        ctx.lineTo(i * 6, y);"
-    "      }"
-    "      ctx.stroke();"
-    "      document.getElementById(`legend-${canvasId.split('-')[1]}`).textContent = `Atual: ${j[dataKey].toFixed(1)}${unit} | Min: ${min.toFixed(1)}${unit} | Max: ${max.toFixed(1)}${unit}`;"
-    "    };"
-    "    drawGraph('grafico-temp', 'temp_aht20', '#ff5555', config.temp_min, config.temp_max, '°C');"
-    "    drawGraph('grafico-hum', 'hum_aht20', '#55aaff', config.hum_min, config.hum_max, '%');"
-    "    drawGraph('grafico-press', 'press_bmp280', '#55ff55', config.press_min, config.press_max, 'hPa');"
-    "  } catch (e) {"
-    "    console.error('Erro ao atualizar dados:', e);"
-    "    dadosEl.textContent = 'Erro ao carregar dados';"
-    "    statusEl.textContent = `Erro: ${e.message}`; statusEl.style.color = '#f44336';"
-    "  }"
-    "}"
-    "setInterval(atualiza, 2000); atualiza(); loadConfig();"
-    "document.getElementById('cfg').addEventListener('submit', async e => {"
-    "  e.preventDefault(); statusEl.textContent = 'Salvando...'; statusEl.style.color = '#4CAF50';"
-    "  try {"
-    "    const f = new FormData(e.target);"
-    "    const data = new URLSearchParams();"
-    "    for (let [key, value] of f.entries()) {"
-    "      if (value.trim() !== '') data.append(key, value);"
-    "    }"
-    "    if (data.toString() === '') {"
-    "      statusEl.textContent = 'Nenhum valor preenchido'; statusEl.style.color = '#f44336';"
-    "      return;"
-    "    }"
-    "    console.log('Enviando dados:', data.toString());"
-    "    const r = await fetch('/cfg', { method: 'POST', headers: { 'Content-Type': 'application/x-www-form-urlencoded' }, body: data });"
-    "    const text = await r.text();"
-    "    console.log('Resposta do servidor:', text);"
-    "    if (!r.ok) throw new Error(`Erro HTTP ${r.status}: ${r.statusText}`);"
-    "    let j;"
-    "    try { j = JSON.parse(text); } catch (e) { throw new Error(`Erro ao parsear JSON: ${e.message}`); }"
-    "    statusEl.textContent = j.message; statusEl.style.color = j.status === 'success' ? '#4CAF50' : '#f44336';"
-    "    await loadConfig();"
-    "  } catch (e) {"
-    "    console.error('Erro no POST:', e);"
-    "    statusEl.textContent = `Erro ao salvar: ${e.message}`; statusEl.style.color = '#f44336';"
-    "    await loadConfig();"
-    "  }"
-    "});"
-    "</script></body></html>";
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer,
+                                    configSTACK_DEPTH_TYPE *puxTimerTaskStackSize)
+{
+    static StaticTask_t tcb_timers;
+    static StackType_t pilha_timers[configTIMER_TASK_STACK_DEPTH];
+    *ppxTimerTaskTCBBuffer = &tcb_timers;
+    *ppxTimerTaskStackBuffer = pilha_timers;
+    *puxTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+#endif
 
 // ===================== FUNÇÃO PRINCIPAL =====================
 int main()
 {
     stdio_init_all();
     inicializar_hardware();
-    mutex_sensor = xSemaphoreCreateMutex();
-    mutex_config = xSemaphoreCreateMutex();
+    pubsub_iniciar();
 
     gpio_set_irq_enabled_with_callback(BTN_1, GPIO_IRQ_EDGE_FALL, true, &manipulador_interrupcao_gpio);
     gpio_set_irq_enabled(BTN_2, GPIO_IRQ_EDGE_FALL, true);
     gpio_set_irq_enabled(BTN_3, GPIO_IRQ_EDGE_FALL, true);
 
-    xTaskCreate(tarefa_leitura_sensores, "LeituraSensores", 1024, NULL, 2, NULL);
-    xTaskCreate(tarefa_webserver, "WebServer", 2048, NULL, 3, NULL);
-    xTaskCreate(tarefa_alerta, "Alerta", 1024, NULL, 2, NULL);
-    xTaskCreate(tarefa_display, "Display", 1024, NULL, 2, NULL);
-    xTaskCreate(tarefa_timeout, "Timeout", 512, NULL, 1, NULL);
+    criar_tarefa(tarefa_leitura_sensores, "LeituraSensores", PILHA_SENSORES, 2, NULL, NUCLEO_APLICACAO);
+    criar_tarefa(tarefa_webserver, "WebServer", PILHA_WEBSERVER, 3, NULL, NUCLEO_REDE);
+    criar_tarefa(tarefa_alerta, "Alerta", PILHA_ALERTA, 2, NULL, NUCLEO_APLICACAO);
+    criar_tarefa(tarefa_display, "Display", PILHA_DISPLAY, 2, NULL, NUCLEO_APLICACAO);
+    criar_tarefa(tarefa_timeout, "Timeout", PILHA_TIMEOUT, 1, NULL, NUCLEO_REDE);
+    criar_tarefa(tarefa_botoes, "Botoes", PILHA_BOTOES, 2, &tarefa_botoes_handle, NUCLEO_APLICACAO);
 
     vTaskStartScheduler();
     while (1)
@@ -324,6 +401,7 @@ void inicializar_hardware(void)
     gpio_pull_up(I2C_DISP_SCL);
 
     bmp280_init(I2C_PORT_SENSORES);
+    i2c_dma_iniciar(&barramento_sensores, I2C_PORT_SENSORES, palavras_sensores, SENSORES_DMA_PALAVRAS);
 
     inicializar_display();
     inicializar_leds();
@@ -340,14 +418,24 @@ void inicializar_hardware(void)
 
 void inicializar_display(void)
 {
-    ssd1306_init(&display, 128, 64, false, DISPLAY_ADDRESS, I2C_PORT_DISPLAY);
+    ssd1306_init(&display, WIDTH, HEIGHT, false, DISPLAY_ADDRESS, I2C_PORT_DISPLAY, colunas_display, envio_display);
     ssd1306_config(&display);
     ssd1306_fill(&display, false);
     ssd1306_send_data(&display);
     sleep_ms(100);
+
+    // Daqui em diante o display é escrito só pela tarefa_display, pela fila com DMA
+    i2c_dma_iniciar(&barramento_display, I2C_PORT_DISPLAY, palavras_display, DISPLAY_DMA_PALAVRAS);
+    ssd1306_set_transport(&display, display_escrever, &barramento_display);
     printf("[INFO] Display OLED inicializado.\n");
 }
 
+// Transporte do SSD1306: copia a transação para a fila do i2c1 e retorna sem esperar
+static int display_escrever(void *contexto, uint8_t endereco, const uint8_t *dados, size_t len)
+{
+    return i2c_dma_escrever(contexto, endereco, dados, len);
+}
+
 void inicializar_leds(void)
 {
     gpio_init(LED_RED_PIN);
@@ -387,12 +475,23 @@ void inicializar_botoes(void)
 // ===================== DISPLAY OLED =====================
 void atualizar_display(void)
 {
-    char buf1[24], buf2[24], buf3[24], buf4[24];
-    ssd1306_fill(&display, false);
-    snprintf(buf1, sizeof(buf1), "Temp: %.1f C", sensor_data.temp_aht20);
-    snprintf(buf2, sizeof(buf2), "Umid: %.1f %%", sensor_data.hum_aht20);
-    snprintf(buf3, sizeof(buf3), "Press: %.1f hPa", sensor_data.press_bmp280);
-    snprintf(buf4, sizeof(buf4), "WiFi: %s", wifi_connected ? "OK" : "---");
+    // Linhas completadas com espaços e cortadas na largura útil (15 caracteres; a pressão
+    // quebra para a linha seguinte): cada caractere sobrescreve a célula inteira, então não é
+    // preciso limpar a tela e só o que mudou é marcado para envio. Sem mudanças,
+    // ssd1306_send_data não usa o barramento.
+    char buf1[16], buf2[16], buf3[31], buf4[16];
+    leitura_t leitura;
+    leitura_obter(&leitura);
+    sensor_texto_t valores;
+    sensor_formatar(&leitura.dados, &valores);
+    char texto[32];
+    snprintf(texto, sizeof(texto), "Temp: %s C", valores.temp);
+    snprintf(buf1, sizeof(buf1), "%-15.15s", texto);
+    snprintf(texto, sizeof(texto), "Umid: %s %%", valores.hum);
+    snprintf(buf2, sizeof(buf2), "%-15.15s", texto);
+    snprintf(texto, sizeof(texto), "Press: %s hPa", valores.press);
+    snprintf(buf3, sizeof(buf3), "%-30.30s", texto);
+    snprintf(buf4, sizeof(buf4), "WiFi: %-9s", wifi_connected ? "OK" : "---");
     ssd1306_draw_string(&display, buf1, 0, 0);
     ssd1306_draw_string(&display, buf2, 0, 16);
     ssd1306_draw_string(&display, buf3, 0, 32);
@@ -403,13 +502,62 @@ void atualizar_display(void)
 // ===================== TAREFA: DISPLAY OLED =====================
 void tarefa_display(void *param)
 {
+    // A tela só muda com uma leitura nova ou com o estado do Wi-Fi
+    int assinante = pubsub_assinar(PUBSUB_BIT(PUBSUB_LEITURA) | PUBSUB_BIT(PUBSUB_REDE));
     while (1)
     {
+#ifdef DISPLAY_REDESENHO_CONTINUO
+        // Medição (tools/http_bench.py): tela cheia redesenhada e enviada sem parar
+        pubsub_aguardar(assinante, 0);
+        ssd1306_invalidate(&display);
+#else
+        pubsub_aguardar(assinante, portMAX_DELAY);
+#endif
+        // O quadro é enfileirado e a tarefa dorme na notificação até o DMA terminar:
+        // a CPU fica livre durante os ~25 ms de uma tela cheia no fio
         atualizar_display();
-        vTaskDelay(pdMS_TO_TICKS(500));
+        if (i2c_dma_aguardar(&barramento_display, 200) != PICO_OK)
+        {
+            // Reenviado por inteiro no próximo aviso
+            printf("[ERRO] Falha ao enviar quadro ao display.\n");
+            ssd1306_invalidate(&display);
+        }
     }
 }
 
+// ===================== CONFIGURAÇÃO =====================
+// config é gravada pelos callbacks do lwIP (interrupção; núcleo 0 no SMP) e pelo botão de
+// reset, e lida pelas tarefas. Ninguém bloqueia esperando por ela: cada acesso copia a
+// struct inteira numa seção crítica curta e trabalha sobre a cópia. As variantes _isr
+// são as dos callbacks do lwIP.
+static void config_ler(config_limits_t *copia)
+{
+    taskENTER_CRITICAL();
+    *copia = config;
+    taskEXIT_CRITICAL();
+}
+
+static void config_gravar(const config_limits_t *nova)
+{
+    taskENTER_CRITICAL();
+    config = *nova;
+    taskEXIT_CRITICAL();
+}
+
+static void config_ler_isr(config_limits_t *copia)
+{
+    UBaseType_t estado = taskENTER_CRITICAL_FROM_ISR();
+    *copia = config;
+    taskEXIT_CRITICAL_FROM_ISR(estado);
+}
+
+static void config_gravar_isr(const config_limits_t *nova)
+{
+    UBaseType_t estado = taskENTER_CRITICAL_FROM_ISR();
+    config = *nova;
+    taskEXIT_CRITICAL_FROM_ISR(estado);
+}
+
 // ===================== ALERTA =====================
 void emitir_alerta(void)
 {
@@ -425,25 +573,36 @@ void emitir_alerta(void)
 
 void tarefa_alerta(void *param)
 {
+    // Reavalia a cada leitura ou mudança de limites; o Wi-Fi entra pelo LED de status
+    int assinante = pubsub_assinar(PUBSUB_BIT(PUBSUB_LEITURA) | PUBSUB_BIT(PUBSUB_CONFIG) | PUBSUB_BIT(PUBSUB_REDE));
     while (1)
     {
+        pubsub_aguardar(assinante, portMAX_DELAY);
         bool alerta = false;
-        if (xSemaphoreTake(mutex_sensor, pdMS_TO_TICKS(100)) && xSemaphoreTake(mutex_config, pdMS_TO_TICKS(100)))
+        leitura_t leitura;
+        leitura_obter(&leitura);
+        const sensor_data_t *d = &leitura.dados;
+        if (leitura.seq == 0)
         {
-            if (sensor_data.temp_aht20 < config.temp_min || sensor_data.temp_aht20 > config.temp_max ||
-                sensor_data.hum_aht20 < config.hum_min || sensor_data.hum_aht20 > config.hum_max ||
-                sensor_data.press_bmp280 < config.press_min || sensor_data.press_bmp280 > config.press_max)
-            {
-                alerta = true;
-            }
-            xSemaphoreGive(mutex_sensor);
-            xSemaphoreGive(mutex_config);
+            // Nenhuma leitura ainda: os zeros iniciais disparariam o alarme no boot
+            atualizar_led_status();
+            continue;
+        }
+        config_limits_t cfg;
+        config_ler(&cfg);
+        if (d->temp_aht20 < cfg.temp_min || d->temp_aht20 > cfg.temp_max ||
+            d->hum_aht20 < cfg.hum_min || d->hum_aht20 > cfg.hum_max ||
+            d->press_bmp280 < cfg.press_min || d->press_bmp280 > cfg.press_max)
+        {
+            alerta = true;
         }
         if (alert_active != alerta)
         {
             if (alerta)
             {
-                printf("[ALERTA] Parâmetro fora do limite! T:%.1f U:%.1f P:%.1f\n", sensor_data.temp_aht20, sensor_data.hum_aht20, sensor_data.press_bmp280);
+                sensor_texto_t valores;
+                sensor_formatar(d, &valores);
+                printf("[ALERTA] Parâmetro fora do limite! T:%s U:%s P:%s\n", valores.temp, valores.hum, valores.press);
                 emitir_alerta();
             }
             else
@@ -453,7 +612,6 @@ void tarefa_alerta(void *param)
         }
         alert_active = alerta;
         atualizar_led_status();
-        vTaskDelay(pdMS_TO_TICKS(500));
     }
 }
 
@@ -474,89 +632,361 @@ void atualizar_led_status(void)
 }
 
 // ===================== TAREFA: LEITURA DE SENSORES =====================
+// Coleta o resultado do AHT20 disparado no tick disparo: a tarefa dorme até o fim da
+// conversão e, se o sensor ainda estiver ocupado, tenta de novo a cada 10 ms
+static bool aht20_coletar(TickType_t disparo, AHT20_Data *aht20)
+{
+    uint8_t resposta[AHT20_TAMANHO_RESPOSTA];
+    // Margem de 2 ticks: o disparo pode ter sido contado no fim de um tick
+    vTaskDelayUntil(&disparo, pdMS_TO_TICKS(AHT20_TEMPO_CONVERSAO_MS + 2));
+    for (int tentativa = 0; tentativa < 3; tentativa++)
+    {
+        if (tentativa > 0)
+            vTaskDelay(pdMS_TO_TICKS(10));
+        if (i2c_dma_ler(&barramento_sensores, AHT20_I2C_ADDR, NULL, 0, resposta, sizeof(resposta)) < 0 ||
+            i2c_dma_aguardar(&barramento_sensores, 100) != PICO_OK)
+            return false;
+        if (aht20_parse(resposta, aht20))
+            return true;
+    }
+    return false;
+}
+
+// Lê status e dados do BMP280 numa só rajada. Se a conversão disparada ainda não
+// terminou (status com o bit measuring), espera 1 ms e tenta de novo: os registradores
+// de dados ainda teriam a amostra anterior.
+static bool bmp280_coletar(uint8_t rajada[BMP280_BURST_LEN])
+{
+    static const uint8_t reg_status = REG_STATUS;
+    for (int tentativa = 0; tentativa < 5; tentativa++)
+    {
+        if (tentativa > 0)
+            vTaskDelay(pdMS_TO_TICKS(1));
+        if (i2c_dma_ler(&barramento_sensores, BMP280_I2C_ADDR, &reg_status, 1, rajada, BMP280_BURST_LEN) < 0 ||
+            i2c_dma_aguardar(&barramento_sensores, 100) != PICO_OK)
+            return false;
+        if (!(rajada[0] & BMP280_STATUS_MEASURING))
+            return true;
+    }
+    return false;
+}
+
 void tarefa_leitura_sensores(void *param)
 {
     AHT20_Data aht20;
     struct bmp280_calib_param bmp280_calib;
+    uint8_t rajada_bmp280[BMP280_BURST_LEN];
+    bmp280_profile_t perfil = BMP280_PROFILE_STANDARD; // Gravado por bmp280_init
+
+    uint32_t ultimo_historico = 0;
 
     bmp280_get_calib_params(I2C_PORT_SENSORES, &bmp280_calib);
     printf("[INFO] Parâmetros de calibração BMP280 carregados.\n");
 
+    TickType_t proximo = xTaskGetTickCount();
     while (1)
     {
-        if (xSemaphoreTake(mutex_sensor, pdMS_TO_TICKS(100)))
+        // Leitura nos buffers locais, sem trava: o I2C lento não atrasa nenhum leitor.
+        // Os dois sensores são disparados juntos (o BMP280 em modo forçado, uma conversão
+        // por ciclo) e dormem até o próximo; nas esperas a tarefa fica bloqueada
+        // (notificação do DMA, vTaskDelayUntil).
+        sensor_data_t nova;
+        uint64_t disparo_us = time_us_64();
+        config_limits_t cfg; // Perfil e offsets de um mesmo estado da configuração
+        config_ler(&cfg);
+        if (cfg.bmp280_perfil != perfil)
         {
-            if (aht20_read(I2C_PORT_SENSORES, &aht20))
-            {
-                sensor_data.temp_aht20 = aht20.temperature + config.temp_offset;
-                sensor_data.hum_aht20 = aht20.humidity + config.hum_offset;
-            }
-            else
-            {
-                printf("[ERRO] Falha na leitura do AHT20.\n");
-                sensor_data.temp_aht20 = 0.0f;
-                sensor_data.hum_aht20 = 0.0f;
-            }
+            // O sensor está em repouso entre as conversões: REG_CONFIG é aceito agora
+            perfil = (bmp280_profile_t)cfg.bmp280_perfil;
+            const uint8_t filtro[2] = {REG_CONFIG, bmp280_profile_config(perfil)};
+            i2c_dma_escrever(&barramento_sensores, BMP280_I2C_ADDR, filtro, sizeof(filtro));
+            printf("[INFO] BMP280: perfil %s (conversão de até %lu us).\n",
+                   bmp280_profile_name(perfil), (unsigned long)bmp280_profile_max_time_us(perfil));
+        }
+        const uint8_t forcado[2] = {REG_CTRL_MEAS, bmp280_profile_ctrl_meas(perfil)};
+        TickType_t disparo = xTaskGetTickCount();
+        i2c_dma_escrever(&barramento_sensores, BMP280_I2C_ADDR, forcado, sizeof(forcado));
+        i2c_dma_escrever(&barramento_sensores, AHT20_I2C_ADDR, aht20_cmd_trigger, sizeof(aht20_cmd_trigger));
+        bool bmp280_ok = i2c_dma_aguardar(&barramento_sensores, 100) == PICO_OK;
+
+        // A conversão do BMP280 (até 44 ms) termina antes da do AHT20 (80 ms)
+        TickType_t fim_bmp280 = disparo;
+        vTaskDelayUntil(&fim_bmp280, pdMS_TO_TICKS((bmp280_profile_max_time_us(perfil) + 999) / 1000 + 1));
+        bmp280_ok = bmp280_ok && bmp280_coletar(rajada_bmp280);
+
+        struct bmp280_reading bmp280 = {0, 0};
+        if (bmp280_ok)
+            bmp280_parse_raw(&rajada_bmp280[BMP280_BURST_DATA], &bmp280.temp, &bmp280.pressure);
+
+        if (bmp280.pressure == 0)
+        {
+            printf("[ERRO] Falha na leitura do BMP280: %s.\n", bmp280_ok ? "pressão bruta zero" : "erro no barramento");
+            nova.press_bmp280 = 0;
+        }
+        else
+        {
+            // Pa são centésimos de hPa: o offset soma direto
+            bmp280_compensate(&bmp280, &bmp280, &bmp280_calib);
+            nova.press_bmp280 = bmp280.pressure + cfg.press_offset;
+        }
 
-            int32_t temp_raw = 0, press_raw = 0;
-            bmp280_read_raw(I2C_PORT_SENSORES, &temp_raw, &press_raw);
+        if (aht20_coletar(disparo, &aht20))
+        {
+            nova.temp_aht20 = aht20.temperature + cfg.temp_offset;
+            nova.hum_aht20 = aht20.humidity + cfg.hum_offset;
+        }
+        else
+        {
+            printf("[ERRO] Falha na leitura do AHT20.\n");
+            nova.temp_aht20 = 0;
+            nova.hum_aht20 = 0;
+        }
 
-            if (press_raw == 0)
-            {
-                printf("[ERRO] Falha na leitura do BMP280: pressão bruta zero.\n");
-                sensor_data.press_bmp280 = 0.0f;
-            }
-            else
-            {
-                sensor_data.press_bmp280 = bmp280_convert_pressure(press_raw, temp_raw, &bmp280_calib) / 100.0f + config.press_offset;
-            }
+        if (log_medicoes)
+        {
+            sensor_texto_t valores;
+            sensor_formatar(&nova, &valores);
+            printf("[SENSORES] Temperatura: %s°C | Umidade: %s%% | Pressão: %s hPa\n",
+                   valores.temp, valores.hum, valores.press);
+        }
 
-            if (log_medicoes)
-            {
-                printf("[SENSORES] Temperatura: %.1f°C | Umidade: %.1f%% | Pressão: %.1f hPa\n",
-                       sensor_data.temp_aht20, sensor_data.hum_aht20, sensor_data.press_bmp280);
-            }
+        // Instante da amostra é o disparo; a latência mostra quanto a aquisição levou
+        uint32_t agora = (uint32_t)(disparo_us / 1000);
+        leitura_publicar(&nova, disparo_us, (uint32_t)(time_us_64() - disparo_us));
+        if (historico_total == 0 || agora - ultimo_historico >= HISTORICO_INTERVALO_MS)
+        {
+            historico_adicionar(&nova, agora);
+            ultimo_historico = agora;
+        }
+        pubsub_publicar(PUBSUB_LEITURA);
+        // Período fixo: o tempo gasto no ciclo não desloca as conversões seguintes
+        vTaskDelayUntil(&proximo, pdMS_TO_TICKS(SENSOR_READ_INTERVAL_MS));
+    }
+}
+
+// ===================== LEITURA PUBLICADA =====================
+// Único escritor: tarefa_leitura_sensores. O buffer em uso pelos leitores só volta a ser
+// escrito na publicação seguinte, então o leitor nunca espera: se leitura_versao mudou
+// durante a cópia (duas publicações no meio dela, 2 s cada), basta copiar de novo.
+static void leitura_publicar(const sensor_data_t *dados, uint64_t t_us, uint32_t latencia_us)
+{
+    uint32_t versao = leitura_versao + 1;
+    const leitura_t *anterior = &leituras[leitura_versao & 1];
+    leitura_t *destino = &leituras[versao & 1];
+    destino->dados = *dados;
+    destino->seq = versao;
+    destino->t_ms = (uint32_t)(t_us / 1000);
+    destino->t_us = t_us;
+    destino->latencia_us = latencia_us;
+    // Com o laço em vTaskDelayUntil, o desvio deste valor em relação a
+    // SENSOR_READ_INTERVAL_MS é o jitter do disparo
+    destino->intervalo_us = versao > 1 ? (uint32_t)(t_us - anterior->t_us) : 0;
+    __atomic_store_n(&leitura_versao, versao, __ATOMIC_RELEASE);
+}
+
+static void leitura_obter(leitura_t *leitura)
+{
+    uint32_t versao;
+    do
+    {
+        versao = __atomic_load_n(&leitura_versao, __ATOMIC_ACQUIRE);
+        *leitura = leituras[versao & 1];
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&leitura_versao, __ATOMIC_RELAXED) != versao);
+}
 
-            xSemaphoreGive(mutex_sensor);
+// Número da última leitura publicada, sem copiá-la
+static uint32_t leitura_seq(void)
+{
+    return __atomic_load_n(&leitura_versao, __ATOMIC_ACQUIRE);
+}
+
+static void sensor_formatar(const sensor_data_t *dados, sensor_texto_t *texto)
+{
+    ponto_fixo_formatar(texto->temp, dados->temp_aht20);
+    ponto_fixo_formatar(texto->hum, dados->hum_aht20);
+    ponto_fixo_formatar(texto->press, dados->press_bmp280);
+}
+
+// Campos JSON de uma leitura, sem as chaves: compartilhados por /json, SSE e WebSocket
+static int montar_campos_leitura(char *buf, size_t len, const leitura_t *leitura)
+{
+    sensor_texto_t valores;
+    sensor_formatar(&leitura->dados, &valores);
+    return snprintf(buf, len, "\"seq\":%lu,\"temp_aht20\":%s,\"hum_aht20\":%s,\"press_bmp280\":%s,"
+                              "\"t_us\":%llu,\"latencia_us\":%lu,\"intervalo_us\":%lu",
+                    (unsigned long)leitura->seq, valores.temp, valores.hum, valores.press,
+                    (unsigned long long)leitura->t_us, (unsigned long)leitura->latencia_us,
+                    (unsigned long)leitura->intervalo_us);
+}
+
+// ===================== HISTÓRICO DE LEITURAS =====================
+// Um único escritor (tarefa_leitura_sensores) e leitores sem bloqueio nos callbacks do
+// lwIP: o leitor copia a amostra e depois confere se ela foi sobrescrita no meio da cópia.
+static void historico_adicionar(const sensor_data_t *dados, uint32_t t_ms)
+{
+    uint32_t total = historico_total;
+    __atomic_store_n(&historico_escrita, total + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    historico[total % HISTORICO_CAPACIDADE].t_ms = t_ms;
+    historico[total % HISTORICO_CAPACIDADE].dados = *dados;
+    __atomic_store_n(&historico_total, total + 1, __ATOMIC_RELEASE);
+}
+
+static bool historico_ler(uint32_t indice, amostra_historico_t *amostra)
+{
+    if (indice >= __atomic_load_n(&historico_total, __ATOMIC_ACQUIRE))
+        return false;
+    *amostra = historico[indice % HISTORICO_CAPACIDADE];
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&historico_escrita, __ATOMIC_RELAXED) <= indice + HISTORICO_CAPACIDADE;
+}
+
+// Índice da amostra mais antiga que ainda não começou a ser sobrescrita
+static uint32_t historico_mais_antiga(void)
+{
+    uint32_t escrita = __atomic_load_n(&historico_escrita, __ATOMIC_ACQUIRE);
+    return escrita > HISTORICO_CAPACIDADE ? escrita - HISTORICO_CAPACIDADE : 0;
+}
+
+// Primeiro índice antes de fim com t_ms > since_ms (busca binária: instantes crescentes)
+static uint32_t historico_buscar(uint32_t since_ms, uint32_t fim)
+{
+    uint32_t ini = historico_mais_antiga();
+    while (ini < fim)
+    {
+        uint32_t meio = ini + (fim - ini) / 2;
+        amostra_historico_t amostra;
+        if (!historico_ler(meio, &amostra))
+        {
+            ini = historico_mais_antiga();
+            continue;
         }
-        vTaskDelay(pdMS_TO_TICKS(SENSOR_READ_INTERVAL_MS));
+        if (amostra.t_ms <= since_ms)
+            ini = meio + 1;
+        else
+            fim = meio;
     }
+    return ini;
+}
+
+// ===================== ESTATÍSTICAS DE EXECUÇÃO =====================
+// uxTaskGetSystemState suspende o escalonador e percorre as listas de tarefas, o que não
+// pode ser feito nos callbacks do lwIP (rodam em interrupção). A tarefa de timeout tira
+// uma amostra a cada STATS_PERIODO_MS na metade livre do buffer duplo e só troca a metade
+// publicada com o lwIP travado; /stats apenas serializa a publicada.
+typedef struct
+{
+    TaskStatus_t tarefas[STATS_MAX_TAREFAS];
+    UBaseType_t total_tarefas;  // 0: nenhuma amostra ainda
+    configRUN_TIME_COUNTER_TYPE total_us;
+    size_t heap_livre;
+    size_t heap_minimo;
+} stats_amostra_t;
+
+static stats_amostra_t stats_amostras[2];
+static uint8_t stats_publicada;
+
+static void stats_amostrar(void)
+{
+    stats_amostra_t *a = &stats_amostras[stats_publicada ^ 1];
+    a->total_tarefas = uxTaskGetSystemState(a->tarefas, STATS_MAX_TAREFAS, &a->total_us);
+#if configSUPPORT_DYNAMIC_ALLOCATION
+    a->heap_livre = xPortGetFreeHeapSize();
+    a->heap_minimo = xPortGetMinimumEverFreeHeapSize();
+#endif
+    cyw43_arch_lwip_begin();
+    stats_publicada ^= 1;
+    cyw43_arch_lwip_end();
 }
 
 // ===================== TAREFA: TIMEOUT DE CONEXÕES =====================
 void tarefa_timeout(void *param)
 {
+    absolute_time_t proxima_amostra = get_absolute_time();
     while (1)
     {
+        if (absolute_time_diff_us(get_absolute_time(), proxima_amostra) <= 0)
+        {
+            stats_amostrar();
+            proxima_amostra = make_timeout_time_ms(STATS_PERIODO_MS);
+        }
+
+        // Fecha tanto requisições travadas quanto conexões keep-alive ociosas e dorme até
+        // o prazo mais próximo. Prazos só são adiados e uma conexão nova nasce com ao
+        // menos HTTP_KEEPALIVE_TIMEOUT_MS, então esse é o maior sono que não atrasa nada.
+        int64_t espera_us = (int64_t)HTTP_KEEPALIVE_TIMEOUT_MS * 1000;
+        cyw43_arch_lwip_begin();
+        absolute_time_t agora = get_absolute_time();
         for (int i = 0; i < MAX_CONNECTIONS; i++)
         {
-            if (active_connections[i] != NULL)
+            conn_state_t *c = &conexoes[i];
+            if (c->pcb != NULL)
             {
-                if (absolute_time_diff_us(get_absolute_time(), active_connections[i]->timeout) / 1000 > TCP_TIMEOUT_MS)
+                int64_t restante_us = absolute_time_diff_us(agora, c->timeout);
+                if (restante_us < 0)
                 {
-                    printf("[TIMEOUT] Fechando conexão inativa com %s\n", ipaddr_ntoa(&active_connections[i]->pcb->remote_ip));
-                    close_connection(active_connections[i]);
-                    active_connections[i] = NULL;
+                    printf("[TIMEOUT] Fechando conexão inativa com %s\n", ipaddr_ntoa(&c->remoto));
+                    close_connection(c);
+                }
+                else if (restante_us < espera_us)
+                {
+                    espera_us = restante_us;
                 }
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        int64_t amostra_us = absolute_time_diff_us(agora, proxima_amostra);
+        if (amostra_us < espera_us)
+            espera_us = amostra_us > 0 ? amostra_us : 0;
+        cyw43_arch_lwip_end();
+        vTaskDelay(pdMS_TO_TICKS(espera_us / 1000) + 1);
     }
 }
 
 // ===================== WEBSERVER =====================
+static const char cors_headers[] = "Access-Control-Allow-Origin: *\r\n"
+                                   "Access-Control-Allow-Methods: GET, POST\r\n"
+                                   "Access-Control-Allow-Headers: Content-Type\r\n";
+
+// Vaga sem PCB e sem callback em andamento (um close_connection dentro de
+// webserver_recv/sent ainda deixa o callback usar o estado até retornar)
+static bool vaga_livre(const conn_state_t *state)
+{
+    return state->pcb == NULL && !state->in_callback;
+}
+
+// Buffers de montagem de resposta (cabeçalho, JSON, cópia do corpo de POST) saem do
+// rascunho da conexão, não da pilha: os callbacks do lwIP rodam na pilha das
+// interrupções. O rascunho recomeça a cada requisição ou frame WebSocket e só precisa
+// durar até o handler retornar, porque tudo o que vai ao lwIP é copiado.
+static char *rascunho_reservar(conn_state_t *state, size_t tamanho)
+{
+    configASSERT(state->rascunho_usado + tamanho <= sizeof(state->rascunho));
+    char *p = state->rascunho + state->rascunho_usado;
+    state->rascunho_usado += (uint16_t)tamanho;
+    return p;
+}
+
+// Maior uso numa requisição: POST /cfg (cópia do corpo, resultado e cabeçalho)
+_Static_assert(HTTP_MAX_CORPO + 1 + CFG_RESPOSTA_MAX + HTTP_CABECALHO_MAX <= CONEXAO_RASCUNHO,
+               "CONEXAO_RASCUNHO não comporta POST /cfg");
+
+// Estado ocioso: resposta anterior confirmada e nenhuma requisição pendente no buffer
+static bool conexao_ociosa(const conn_state_t *state)
+{
+    return state->remaining_len == 0 && !state->gerador && state->bytes_acked >= state->bytes_queued &&
+           state->pendente == NULL && state->parser.cabecalhos_len == 0;
+}
+
 void close_connection(conn_state_t *state)
 {
     if (state == NULL || state->pcb == NULL)
         return;
 
-    for (int i = 0; i < MAX_CONNECTIONS; i++)
+    if (state->pendente)
     {
-        if (active_connections[i] == state)
-        {
-            active_connections[i] = NULL;
-            break;
-        }
+        pbuf_free(state->pendente);
+        state->pendente = NULL;
     }
 
     tcp_arg(state->pcb, NULL);
@@ -568,14 +998,83 @@ void close_connection(conn_state_t *state)
     {
         printf("[ERRO] Falha ao fechar conexão: %d\n", err);
     }
-    free(state);
+    state->pcb = NULL;
 }
 
-void send_http_response(struct tcp_pcb *tpcb, const char *header, const char *body, conn_state_t *state)
+// Monta o cabeçalho de uma resposta; Connection/Keep-Alive seguem o estado da conexão
+static void montar_cabecalho(char *buf, size_t buf_len, const char *status, const char *content_type,
+                             const char *extra, size_t content_length, const conn_state_t *state)
+{
+    char conexao[64];
+    if (state->keep_alive)
+        snprintf(conexao, sizeof(conexao), "Connection: keep-alive\r\nKeep-Alive: timeout=%d\r\n", HTTP_KEEPALIVE_TIMEOUT_MS / 1000);
+    else
+        snprintf(conexao, sizeof(conexao), "Connection: close\r\n");
+
+    // Corpo de tamanho desconhecido: chunked, ou delimitado pelo fechamento em HTTP/1.0
+    char tamanho[40];
+    if (content_length != HTTP_TAMANHO_INDEFINIDO)
+        snprintf(tamanho, sizeof(tamanho), "Content-Length: %zu\r\n", content_length);
+    else if (state->chunked)
+        snprintf(tamanho, sizeof(tamanho), "Transfer-Encoding: chunked\r\n");
+    else
+        tamanho[0] = '\0';
+
+    snprintf(buf, buf_len, "HTTP/1.1 %s\r\nContent-Type: %s\r\n%s%s%s%s\r\n",
+             status, content_type, extra ? extra : "", cors_headers, tamanho, conexao);
+}
+
+// Enfileira o máximo do corpo estático pendente que cabe em tcp_sndbuf(), sem cópia.
+// Em ERR_MEM reduz o pedaço pela metade; o restante segue no próximo ACK.
+static err_t enviar_corpo_estatico(struct tcp_pcb *tpcb, conn_state_t *state)
+{
+    while (state->remaining_len > 0)
+    {
+        u16_t len = tcp_sndbuf(tpcb);
+        if (len == 0)
+            break;
+        if (len > state->remaining_len)
+            len = (u16_t)state->remaining_len;
+
+        err_t err;
+        do
+        {
+            u8_t flags = (state->remaining_len > len ? TCP_WRITE_FLAG_MORE : 0) |
+                         (state->copiar_corpo ? TCP_WRITE_FLAG_COPY : 0);
+            err = tcp_write(tpcb, state->remaining_data, len, flags);
+            if (err == ERR_MEM)
+                len /= 2;
+        } while (err == ERR_MEM && len > 0);
+
+        if (err == ERR_MEM)
+        {
+            // Sem nada em voo não haverá ACK para retomar o envio
+            return tcp_sndqueuelen(tpcb) == 0 ? ERR_MEM : ERR_OK;
+        }
+        if (err != ERR_OK)
+            return err;
+
+        state->remaining_data += len;
+        state->remaining_len -= len;
+        state->bytes_queued += len;
+    }
+    return ERR_OK;
+}
+
+static err_t enviar_cabecalho(struct tcp_pcb *tpcb, const char *header, bool more, conn_state_t *state)
 {
-    err_t err;
+    size_t len = strlen(header);
+    err_t err = tcp_write(tpcb, header, len, TCP_WRITE_FLAG_COPY | (more ? TCP_WRITE_FLAG_MORE : 0));
+    if (err == ERR_OK)
+        state->bytes_queued += len;
+    return err;
+}
 
-    err = tcp_write(tpcb, header, strlen(header), TCP_WRITE_FLAG_COPY);
+// Resposta com corpo dinâmico (buffer na pilha do chamador): cabeçalho e corpo são copiados
+void send_http_response(struct tcp_pcb *tpcb, const char *header, const char *body, conn_state_t *state)
+{
+    size_t body_len = body ? strlen(body) : 0;
+    err_t err = enviar_cabecalho(tpcb, header, body_len > 0, state);
     if (err != ERR_OK)
     {
         printf("[ERRO] Falha ao enviar cabeçalho HTTP: %d\n", err);
@@ -583,26 +1082,19 @@ void send_http_response(struct tcp_pcb *tpcb, const char *header, const char *bo
         return;
     }
 
-    if (body && strlen(body) > 0)
+    if (body_len > 0)
     {
-        state->remaining_data = body;
-        state->remaining_len = strlen(body);
-        size_t to_send = state->remaining_len > TCP_CHUNK_SIZE ? TCP_CHUNK_SIZE : state->remaining_len;
-        err = tcp_write(tpcb, state->remaining_data, to_send, TCP_WRITE_FLAG_COPY);
+        err = tcp_write(tpcb, body, body_len, TCP_WRITE_FLAG_COPY);
         if (err != ERR_OK)
         {
             printf("[ERRO] Falha ao enviar corpo HTTP: %d\n", err);
             close_connection(state);
             return;
         }
-        state->remaining_data += to_send;
-        state->remaining_len -= to_send;
-    }
-    else
-    {
-        state->remaining_data = NULL;
-        state->remaining_len = 0;
+        state->bytes_queued += body_len;
     }
+    state->remaining_data = NULL;
+    state->remaining_len = 0;
 
     err = tcp_output(tpcb);
     if (err != ERR_OK)
@@ -615,38 +1107,189 @@ void send_http_response(struct tcp_pcb *tpcb, const char *header, const char *bo
     state->response_sent = true;
 }
 
+// Corpo enviado aos pedaços a cada ACK; sem copiar, o lwIP lê body até ele ser confirmado
+static void enviar_resposta_em_partes(struct tcp_pcb *tpcb, const char *header, const char *body, size_t body_len,
+                                      bool copiar, conn_state_t *state)
+{
+    err_t err = enviar_cabecalho(tpcb, header, body_len > 0, state);
+    if (err != ERR_OK)
+    {
+        printf("[ERRO] Falha ao enviar cabeçalho HTTP: %d\n", err);
+        close_connection(state);
+        return;
+    }
+
+    state->remaining_data = body;
+    state->remaining_len = body_len;
+    state->copiar_corpo = copiar;
+    err = enviar_corpo_estatico(tpcb, state);
+    if (err == ERR_OK)
+        err = tcp_output(tpcb);
+    if (err != ERR_OK)
+    {
+        printf("[ERRO] Falha ao enviar corpo HTTP: %d\n", err);
+        close_connection(state);
+        return;
+    }
+
+    state->response_sent = true;
+}
+
+// Resposta com corpo imutável (ex.: html_page): o lwIP referencia o corpo sem copiá-lo
+// para o heap MEM_SIZE, preenchendo a janela de envio a cada ACK.
+void send_http_response_static(struct tcp_pcb *tpcb, const char *header, const char *body, size_t body_len, conn_state_t *state)
+{
+    enviar_resposta_em_partes(tpcb, header, body, body_len, false, state);
+}
+
+// Corpo maior que o buffer de envio num buffer que será reescrito: cada pedaço é copiado
+// ao ser enfileirado, então o buffer fica livre assim que remaining_len chega a zero.
+static void send_http_response_buffer(struct tcp_pcb *tpcb, const char *header, const char *body, size_t body_len,
+                                      conn_state_t *state)
+{
+    enviar_resposta_em_partes(tpcb, header, body, body_len, true, state);
+}
+
+// Chama o gerador enquanto houver espaço em tcp_sndbuf(), copiando cada parte para o
+// lwIP. O espaço é conferido antes de gerar porque o gerador avança o próprio cursor.
+static err_t enviar_corpo_gerado(struct tcp_pcb *tpcb, conn_state_t *state)
+{
+    // Também chamada fora de requisições (ACKs, eventos_notificar): devolve o que reservou
+    uint16_t marca = state->rascunho_usado;
+    err_t err = ERR_OK;
+    char *buf = rascunho_reservar(state, 8 + CORPO_GERADO_MAX + 8); // Tamanho do chunk + dados + "\r\n" + "0\r\n\r\n"
+    while (state->gerador)
+    {
+        size_t livre = tcp_sndbuf(tpcb);
+        if (livre < 128 || tcp_sndqueuelen(tpcb) + 2 > TCP_SND_QUEUELEN)
+            break;
+
+        size_t max = livre - 16;
+        if (max > CORPO_GERADO_MAX)
+            max = CORPO_GERADO_MAX;
+
+        bool fim = false;
+        char *dados = buf + 8;
+        size_t n = state->gerador(state, dados, max, &fim);
+        char *inicio = dados;
+        size_t total = n;
+        if (state->chunked)
+        {
+            if (n > 0)
+            {
+                char prefixo[8];
+                int p = snprintf(prefixo, sizeof(prefixo), "%x\r\n", (unsigned)n);
+                inicio -= p;
+                memcpy(inicio, prefixo, p);
+                memcpy(dados + n, "\r\n", 2);
+                total += p + 2;
+            }
+            if (fim)
+            {
+                memcpy(inicio + total, "0\r\n\r\n", 5);
+                total += 5;
+            }
+        }
+        if (fim)
+            state->gerador = NULL;
+        if (total == 0)
+            break;
+
+        err = tcp_write(tpcb, inicio, total, TCP_WRITE_FLAG_COPY);
+        if (err != ERR_OK)
+            break;
+        state->bytes_queued += total;
+    }
+    state->rascunho_usado = marca;
+    return err;
+}
+
+// Resposta com corpo gerado em partes pelo callback gerador (cabeçalho já montado)
+static void send_http_response_gerada(struct tcp_pcb *tpcb, const char *header,
+                                      size_t (*gerador)(conn_state_t *, char *, size_t, bool *), conn_state_t *state)
+{
+    err_t err = enviar_cabecalho(tpcb, header, true, state);
+    if (err != ERR_OK)
+    {
+        printf("[ERRO] Falha ao enviar cabeçalho HTTP: %d\n", err);
+        close_connection(state);
+        return;
+    }
+
+    state->remaining_data = NULL;
+    state->remaining_len = 0;
+    state->gerador = gerador;
+    err = enviar_corpo_gerado(tpcb, state);
+    if (err == ERR_OK)
+        err = tcp_output(tpcb);
+    if (err != ERR_OK)
+    {
+        printf("[ERRO] Falha ao enviar corpo HTTP: %d\n", err);
+        close_connection(state);
+        return;
+    }
+
+    state->response_sent = true;
+}
+
 static err_t webserver_sent(void *arg, struct tcp_pcb *tpcb, u16_t len)
 {
     conn_state_t *state = (conn_state_t *)arg;
     if (!state)
         return ERR_OK;
 
+    state->bytes_acked += len;
+    state->timeout = make_timeout_time_ms(TCP_TIMEOUT_MS);
+    state->ack_count++;
+
+    state->in_callback = true;
     if (state->remaining_len > 0)
     {
-        size_t to_send = state->remaining_len > TCP_CHUNK_SIZE ? TCP_CHUNK_SIZE : state->remaining_len;
-        err_t err = tcp_write(tpcb, state->remaining_data, to_send, TCP_WRITE_FLAG_COPY);
+        err_t err = enviar_corpo_estatico(tpcb, state);
+        if (err == ERR_OK)
+            err = tcp_output(tpcb);
         if (err != ERR_OK)
         {
             printf("[ERRO] Falha ao enviar pedaço restante do corpo HTTP: %d\n", err);
             close_connection(state);
-            return ERR_OK;
         }
-        state->remaining_data += to_send;
-        state->remaining_len -= to_send;
-
-        err = tcp_output(tpcb);
+    }
+    else if (state->gerador)
+    {
+        err_t err = enviar_corpo_gerado(tpcb, state);
+        if (err == ERR_OK)
+            err = tcp_output(tpcb);
         if (err != ERR_OK)
         {
-            printf("[ERRO] Falha ao forçar envio TCP de pedaço: %d\n", err);
+            printf("[ERRO] Falha ao enviar pedaço do corpo gerado: %d\n", err);
             close_connection(state);
-            return ERR_OK;
         }
     }
-    else
+
+    // Respostas a requisições em pipeline esperam a anterior ser toda enfileirada;
+    // no WebSocket o ACK libera espaço na fila para ler os frames retidos
+    if (state->pcb && state->remaining_len == 0 && (!state->gerador || state->ws))
+        processar_requisicoes(tpcb, state);
+
+    if (state->pcb && state->remaining_len == 0 && !state->gerador && state->bytes_acked >= state->bytes_queued)
     {
-        printf("[WEBSERVER] Dados enviados completamente para %s\n", ipaddr_ntoa(&tpcb->remote_ip));
-        close_connection(state);
+        printf("[WEBSERVER] Dados enviados completamente para %s: %lu bytes em %u ACKs (%lu bytes/ACK)\n",
+               ipaddr_ntoa(&tpcb->remote_ip), (unsigned long)state->bytes_acked, state->ack_count,
+               (unsigned long)(state->bytes_acked / state->ack_count));
+        if (state->keep_alive && !(state->fin_recebido && state->pendente == NULL))
+        {
+            state->bytes_acked = 0;
+            state->bytes_queued = 0;
+            state->ack_count = 0;
+            state->timeout = make_timeout_time_ms(HTTP_KEEPALIVE_TIMEOUT_MS);
+        }
+        else
+        {
+            close_connection(state);
+        }
     }
+
+    state->in_callback = false;
     return ERR_OK;
 }
 
@@ -655,346 +1298,1017 @@ static void webserver_error(void *arg, err_t err)
     conn_state_t *state = (conn_state_t *)arg;
     if (state)
     {
-        printf("[WEBSERVER] Erro na conexão com %s: %d\n", ipaddr_ntoa(&state->pcb->remote_ip), err);
-        close_connection(state);
+        // O lwIP já liberou o PCB ao chamar este callback: sem PCB a vaga fica livre
+        printf("[WEBSERVER] Erro na conexão com %s: %d\n", ipaddr_ntoa(&state->remoto), err);
+        if (state->pendente)
+            pbuf_free(state->pendente);
+        state->pendente = NULL;
+        state->pcb = NULL;
     }
 }
 
-static void handle_http_request(struct tcp_pcb *tpcb, const char *req, conn_state_t *state)
+// Resposta curta em texto puro, usada para erros do parser e rotas inexistentes
+static void responder_texto(struct tcp_pcb *tpcb, conn_state_t *state, uint16_t status, const char *extra)
 {
-    if (!req || strlen(req) == 0)
-    {
-        printf("[ERRO] Requisição vazia ou nula\n");
-        send_http_response(tpcb, "HTTP/1.1 400 Bad Request\r\nContent-Type: text/plain\r\nConnection: close\r\nContent-Length: 11\r\n\r\nBad Request", NULL, state);
+    const char *texto = http_status_texto(status);
+    char *header = rascunho_reservar(state, HTTP_CABECALHO_MAX);
+    montar_cabecalho(header, HTTP_CABECALHO_MAX, texto, "text/plain", extra, strlen(texto), state);
+    send_http_response(tpcb, header, texto, state);
+}
+
+// Cabeçalho enxuto para clientes não-navegador: sem CORS e sem Keep-Alive (padrão no HTTP/1.1)
+static void montar_cabecalho_minimo(char *buf, size_t buf_len, const char *content_type, size_t content_length,
+                                    const http_parser_t *req, const conn_state_t *state)
+{
+    const char *conexao = "";
+    if (!state->keep_alive)
+        conexao = "Connection: close\r\n";
+    else if (req->http10)
+        conexao = "Connection: keep-alive\r\n";
+    snprintf(buf, buf_len, "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %zu\r\n%s\r\n",
+             content_type, content_length, conexao);
+}
+
+static void escrever_u16_le(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void escrever_u32_le(uint8_t *p, uint32_t v)
+{
+    escrever_u16_le(p, (uint16_t)v);
+    escrever_u16_le(p + 2, (uint16_t)(v >> 16));
+}
+
+// Satura o valor no intervalo do campo
+static int32_t limitar(int32_t valor, int32_t min, int32_t max)
+{
+    return valor < min ? min : valor > max ? max : valor;
+}
+
+// ===================== ROTAS HTTP =====================
+static void rota_bin(struct tcp_pcb *tpcb, const http_parser_t *req, conn_state_t *state)
+{
+    leitura_t leitura;
+    leitura_obter(&leitura);
+    uint8_t registro[TELEMETRIA_TAMANHO];
+    registro[0] = TELEMETRIA_VERSAO;
+    registro[1] = TELEMETRIA_TAMANHO;
+    // Temperatura e umidade já estão em centésimos; a pressão vai em décimos de hPa
+    escrever_u16_le(&registro[2], (uint16_t)limitar(leitura.dados.temp_aht20, INT16_MIN, INT16_MAX));
+    escrever_u16_le(&registro[4], (uint16_t)limitar(leitura.dados.hum_aht20, 0, UINT16_MAX));
+    escrever_u16_le(&registro[6], (uint16_t)limitar((leitura.dados.press_bmp280 + 5) / 10, 0, UINT16_MAX));
+    escrever_u32_le(&registro[8], leitura.seq);
+    escrever_u32_le(&registro[12], leitura.t_ms);
+
+    // Cabeçalho e registro num único segmento copiado
+    char *resposta = rascunho_reservar(state, 128 + TELEMETRIA_TAMANHO);
+    montar_cabecalho_minimo(resposta, 128, "application/octet-stream", TELEMETRIA_TAMANHO, req, state);
+    size_t len = strlen(resposta);
+    memcpy(resposta + len, registro, TELEMETRIA_TAMANHO);
+    err_t err = tcp_write(tpcb, resposta, len + TELEMETRIA_TAMANHO, TCP_WRITE_FLAG_COPY);
+    if (err == ERR_OK)
+        err = tcp_output(tpcb);
+    if (err != ERR_OK)
+    {
+        printf("[ERRO] Falha ao enviar telemetria binária: %d\n", err);
+        close_connection(state);
+        return;
+    }
+    state->bytes_queued += len + TELEMETRIA_TAMANHO;
+    state->remaining_data = NULL;
+    state->remaining_len = 0;
+    state->response_sent = true;
+}
+
+static void rota_json(struct tcp_pcb *tpcb, const http_parser_t *req, conn_state_t *state)
+{
+    if (req->aceita_binario)
+    {
+        rota_bin(tpcb, req, state);
         return;
     }
+    leitura_t leitura;
+    leitura_obter(&leitura);
+    char *campos = rascunho_reservar(state, 192);
+    montar_campos_leitura(campos, 192, &leitura);
+    char *json = rascunho_reservar(state, 200);
+    snprintf(json, 200, "{%s}", campos);
+    char *header = rascunho_reservar(state, HTTP_CABECALHO_MAX);
+    montar_cabecalho(header, HTTP_CABECALHO_MAX, "200 OK", "application/json", "Vary: Accept\r\n", strlen(json), state);
+    send_http_response(tpcb, header, json, state);
+}
+
+static int montar_json_config(char *buf, size_t len, const config_limits_t *cfg)
+{
+    const struct
+    {
+        const char *nome;
+        int32_t valor;
+    } campos[] = {
+        {"temp_min", cfg->temp_min}, {"temp_max", cfg->temp_max},
+        {"hum_min", cfg->hum_min}, {"hum_max", cfg->hum_max},
+        {"press_min", cfg->press_min}, {"press_max", cfg->press_max},
+        {"temp_offset", cfg->temp_offset}, {"hum_offset", cfg->hum_offset}, {"press_offset", cfg->press_offset},
+    };
+    // Como snprintf: retorna o comprimento total mesmo se buf for pequeno demais
+    int n = 0;
+    for (size_t i = 0; i < sizeof(campos) / sizeof(campos[0]); i++)
+    {
+        char valor[PONTO_FIXO_TEXTO_MAX];
+        ponto_fixo_formatar(valor, campos[i].valor);
+        size_t usado = (size_t)n < len ? (size_t)n : len;
+        n += snprintf(buf + usado, len - usado, "%s\"%s\":%s", i ? "," : "{", campos[i].nome, valor);
+    }
+    size_t usado = (size_t)n < len ? (size_t)n : len;
+    n += snprintf(buf + usado, len - usado, ",\"bmp280_perfil\":%u}", (unsigned)cfg->bmp280_perfil);
+    return n;
+}
 
-    printf("[WEBSERVER] Processando requisição de %s: %.50s...\n", ipaddr_ntoa(&tpcb->remote_ip), req);
+static void rota_config(struct tcp_pcb *tpcb, const http_parser_t *req, conn_state_t *state)
+{
+    (void)req;
+    config_limits_t cfg;
+    config_ler_isr(&cfg);
+    char *json = rascunho_reservar(state, 256);
+    montar_json_config(json, 256, &cfg);
+    char *header = rascunho_reservar(state, HTTP_CABECALHO_MAX);
+    montar_cabecalho(header, HTTP_CABECALHO_MAX, "200 OK", "application/json", NULL, strlen(json), state);
+    send_http_response(tpcb, header, json, state);
+}
 
-    const char *cors_headers = "Access-Control-Allow-Origin: *\r\n"
-                               "Access-Control-Allow-Methods: GET, POST\r\n"
-                               "Access-Control-Allow-Headers: Content-Type\r\n";
+// Como snprintf a partir de buf + n, com n podendo já ter passado de len; retorna o
+// comprimento total do texto, mesmo se truncado
+static int anexar(char *buf, size_t len, int n, const char *fmt, ...)
+{
+    size_t usado = (size_t)n < len ? (size_t)n : len;
+    va_list args;
+    va_start(args, fmt);
+    n += vsnprintf(buf + usado, len - usado, fmt, args);
+    va_end(args);
+    return n;
+}
 
-    if (strstr(req, "GET /json") != NULL)
+static int anexar_uso_lwip(char *buf, size_t len, int n, const char *nome, const struct stats_mem *uso)
+{
+    return anexar(buf, len, n, "\"%s\":{\"usado\":%u,\"max\":%u,\"total\":%u,\"erros\":%u}", nome,
+                  (unsigned)uso->used, (unsigned)uso->max, (unsigned)uso->avail, (unsigned)uso->err);
+}
+
+// O JSON é maior que o rascunho de uma conexão e que o buffer de envio do TCP: fica em
+// memória global e segue com cópia a cada ACK (send_http_response_buffer). Só pode ser
+// remontado quando nenhuma conexão tem parte dele por enfileirar.
+static char stats_json[STATS_JSON_MAX];
+
+static bool stats_em_envio(void)
+{
+    for (int i = 0; i < MAX_CONNECTIONS; i++)
+    {
+        const conn_state_t *c = &conexoes[i];
+        if (c->pcb && c->remaining_len > 0 && c->remaining_data >= stats_json &&
+            c->remaining_data < stats_json + sizeof(stats_json))
+            return true;
+    }
+    return false;
+}
+
+// GET /stats: CPU e pilha livre por tarefa, heap do FreeRTOS e ocupação do lwIP. "cpu" é
+// a fração (%) do tempo desde o boot; "tempo_us" permite calcular janelas entre chamadas.
+// Os dados das tarefas são os da última amostra (até STATS_PERIODO_MS de idade).
+static void rota_stats(struct tcp_pcb *tpcb, const http_parser_t *req, conn_state_t *state)
+{
+    (void)req;
+    const stats_amostra_t *a = &stats_amostras[stats_publicada];
+    if (stats_em_envio() || a->total_tarefas == 0)
     {
-        char json[128];
-        snprintf(json, sizeof(json), "{\"temp_aht20\":%.1f,\"hum_aht20\":%.1f,\"press_bmp280\":%.1f}",
-                 sensor_data.temp_aht20, sensor_data.hum_aht20, sensor_data.press_bmp280);
-        char header[256];
-        snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n%sContent-Length: %zu\r\nConnection: close\r\n\r\n", cors_headers, strlen(json));
-        send_http_response(tpcb, header, json, state);
+        responder_texto(tpcb, state, 503, "Retry-After: 1\r\n");
+        return;
+    }
+
+    // No SMP o tempo de cada núcleo conta separado: 100% são todos os núcleos ocupados
+    uint64_t capacidade = (uint64_t)a->total_us * configNUM_CORES;
+
+    int n = anexar(stats_json, sizeof(stats_json), 0, "{\"total_us\":%llu,\"nucleos\":%d,\"tarefas\":[",
+                   (unsigned long long)a->total_us, configNUM_CORES);
+    for (UBaseType_t i = 0; i < a->total_tarefas; i++)
+    {
+        const TaskStatus_t *t = &a->tarefas[i];
+        char cpu[PONTO_FIXO_TEXTO_MAX];
+        ponto_fixo_formatar(cpu, capacidade ? (int32_t)((uint64_t)t->ulRunTimeCounter * 10000u / capacidade) : 0);
+        n = anexar(stats_json, sizeof(stats_json), n,
+                   "%s{\"nome\":\"%s\",\"estado\":\"%c\",\"prioridade\":%u,\"cpu\":%s,\"tempo_us\":%llu,\"pilha_livre\":%u}",
+                   i ? "," : "", t->pcTaskName, "XRBSD?"[t->eCurrentState < eInvalid ? t->eCurrentState : eInvalid],
+                   (unsigned)t->uxCurrentPriority, cpu, (unsigned long long)t->ulRunTimeCounter,
+                   (unsigned)(t->usStackHighWaterMark * sizeof(StackType_t)));
     }
-    else if (strstr(req, "GET /config") != NULL)
+#if configSUPPORT_DYNAMIC_ALLOCATION
+    n = anexar(stats_json, sizeof(stats_json), n, "],\"heap\":{\"livre\":%u,\"minimo\":%u},\"lwip\":{",
+               (unsigned)a->heap_livre, (unsigned)a->heap_minimo);
+#else
+    n = anexar(stats_json, sizeof(stats_json), n, "],\"heap\":null,\"lwip\":{"); // Sem heap no modo estático
+#endif
+    n = anexar_uso_lwip(stats_json, sizeof(stats_json), n, "mem", &lwip_stats.mem);
+    n = anexar(stats_json, sizeof(stats_json), n, ",");
+    n = anexar_uso_lwip(stats_json, sizeof(stats_json), n, "tcp_pcb", lwip_stats.memp[MEMP_TCP_PCB]);
+    n = anexar(stats_json, sizeof(stats_json), n, ",");
+    n = anexar_uso_lwip(stats_json, sizeof(stats_json), n, "tcp_seg", lwip_stats.memp[MEMP_TCP_SEG]);
+    n = anexar(stats_json, sizeof(stats_json), n, ",");
+    n = anexar_uso_lwip(stats_json, sizeof(stats_json), n, "pbuf", lwip_stats.memp[MEMP_PBUF]);
+    n = anexar(stats_json, sizeof(stats_json), n, ",");
+    n = anexar_uso_lwip(stats_json, sizeof(stats_json), n, "pbuf_pool", lwip_stats.memp[MEMP_PBUF_POOL]);
+    n = anexar(stats_json, sizeof(stats_json), n, "}}");
+
+    if ((size_t)n >= sizeof(stats_json))
     {
-        char json[256];
-        snprintf(json, sizeof(json), "{\"temp_min\":%.1f,\"temp_max\":%.1f,\"hum_min\":%.1f,\"hum_max\":%.1f,\"press_min\":%.1f,\"press_max\":%.1f,\"temp_offset\":%.1f,\"hum_offset\":%.1f,\"press_offset\":%.1f}",
-                 config.temp_min, config.temp_max, config.hum_min, config.hum_max, config.press_min, config.press_max,
-                 config.temp_offset, config.hum_offset, config.press_offset);
-        char header[256];
-        snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n%sContent-Length: %zu\r\nConnection: close\r\n\r\n", cors_headers, strlen(json));
-        send_http_response(tpcb, header, json, state);
+        printf("[ERRO] Estatísticas não couberam em %u bytes (%u tarefas)\n", (unsigned)sizeof(stats_json),
+               (unsigned)a->total_tarefas);
+        responder_texto(tpcb, state, 500, NULL);
+        return;
     }
-    else if (strstr(req, "POST /cfg") != NULL)
+    char *header = rascunho_reservar(state, HTTP_CABECALHO_MAX);
+    montar_cabecalho(header, HTTP_CABECALHO_MAX, "200 OK", "application/json", "Cache-Control: no-store\r\n", (size_t)n, state);
+    send_http_response_buffer(tpcb, header, stats_json, (size_t)n, state);
+}
+
+// Aplica os pares chave=valor (x-www-form-urlencoded) de corpo, que é alterado, e escreve
+// em resposta o JSON com os campos aceitos e recusados. Usada por POST /cfg e pelo WebSocket.
+static bool aplicar_configuracao(char *corpo, char *resposta, size_t resposta_len)
+{
+    bool updated = false;
+    char updates[256] = "[";
+    char errors[256] = "[";
+    bool first_update = true, first_error = true;
+
+    // Validada e alterada na cópia e gravada de uma vez: quem ler config vê o estado
+    // anterior ou o novo inteiro, nunca um limite mínimo novo com o máximo antigo
+    config_limits_t cfg;
+    config_ler_isr(&cfg);
+
+    // strtok_r e strchr: um strtok aninhado perdia todos os pares após o primeiro
+    char *salvo_pares = NULL;
+    char *pair = strtok_r(corpo, "&", &salvo_pares);
+    while (pair)
     {
-        const char *body = strstr(req, "\r\n\r\n");
-        if (!body)
+        printf("[CONFIG] Recebido par: %s\n", pair);
+        char *key = pair;
+        char *value = strchr(pair, '=');
+        if (value)
+            *value++ = '\0';
+
+        if (!value || strlen(key) == 0 || strlen(value) == 0)
         {
-            printf("[ERRO] Corpo da requisição POST não encontrado\n");
-            char header[256];
-            snprintf(header, sizeof(header), "HTTP/1.1 400 Bad Request\r\nContent-Type: application/json\r\n%sContent-Length: 45\r\nConnection: close\r\n\r\n", cors_headers);
-            send_http_response(tpcb, header, "{\"status\":\"error\",\"message\":\"Corpo ausente\"}", state);
-            return;
+            printf("[INFO] Ignorando par inválido ou vazio: %s\n", key);
+            pair = strtok_r(NULL, "&", &salvo_pares);
+            continue;
         }
 
-        body += 4;
-        char *body_copy = strdup(body);
-        if (!body_copy)
+        int32_t val;
+        if (!ponto_fixo_ler(value, &val))
         {
-            printf("[ERRO] Falha ao alocar memória para corpo da requisição\n");
-            char header[256];
-            snprintf(header, sizeof(header), "HTTP/1.1 500 Internal Server Error\r\nContent-Type: application/json\r\n%sContent-Length: 48\r\nConnection: close\r\n\r\n", cors_headers);
-            send_http_response(tpcb, header, "{\"status\":\"error\",\"message\":\"Erro interno\"}", state);
-            return;
+            printf("[ERRO] Valor inválido para %s: %s\n", key, value);
+            char err_buf[96]; // Nome com o motivo (até 31) e valor (até 12) sem truncar o JSON
+            snprintf(err_buf, sizeof(err_buf), "{\"field\":\"%s\",\"error\":\"Valor inválido: %s\"}", key, value);
+            if (!first_error) strncat(errors, ",", sizeof(errors) - strlen(errors) - 1);
+            strncat(errors, err_buf, sizeof(errors) - strlen(errors) - 1);
+            first_error = false;
+            pair = strtok_r(NULL, "&", &salvo_pares);
+            continue;
         }
 
-        bool updated = false;
-        char response[512] = "{\"status\":\"success\",\"message\":\"Configuração salva\",\"updates\":[],\"errors\":[]}";
-        char updates[256] = "[";
-        char errors[256] = "[";
-        bool first_update = true, first_error = true;
+        char val_txt[PONTO_FIXO_TEXTO_MAX], limite_txt[PONTO_FIXO_TEXTO_MAX];
+        ponto_fixo_formatar(val_txt, val);
+        bool valid = false;
+        char field_name[32];
+        snprintf(field_name, sizeof(field_name), "%s", key);
 
-        if (xSemaphoreTake(mutex_config, pdMS_TO_TICKS(100)))
+        if (strcmp(key, "temp_min") == 0)
         {
-            char *pair = strtok(body_copy, "&");
-            while (pair)
+            if (val >= -5000 && val <= 5000)
             {
-                char *key = strtok(pair, "=");
-                char *value = strtok(NULL, "=");
-                printf("[CONFIG] Recebido par: %s\n", pair);
-
-                if (!key || !value || strlen(value) == 0)
-                {
-                    printf("[INFO] Ignorando par inválido ou vazio: %s\n", pair ? pair : "nulo");
-                    pair = strtok(NULL, "&");
-                    continue;
-                }
-
-                float val;
-                if (sscanf(value, "%f", &val) != 1)
-                {
-                    printf("[ERRO] Valor inválido para %s: %s\n", key, value);
-                    char err_buf[64];
-                    snprintf(err_buf, sizeof(err_buf), "{\"field\":\"%s\",\"error\":\"Valor inválido: %s\"}", key, value);
-                    if (!first_error) strncat(errors, ",", sizeof(errors) - strlen(errors) - 1);
-                    strncat(errors, err_buf, sizeof(errors) - strlen(errors) - 1);
-                    first_error = false;
-                    pair = strtok(NULL, "&");
-                    continue;
-                }
-
-                bool valid = false;
-                char field_name[32];
-                snprintf(field_name, sizeof(field_name), "%s", key);
-
-                if (strcmp(key, "temp_min") == 0)
+                if (val < cfg.temp_max)
                 {
-                    if (val >= -50.0f && val <= 50.0f)
-                    {
-                        if (val < config.temp_max)
-                        {
-                            config.temp_min = val;
-                            valid = true;
-                            printf("[CONFIG] Novo temp_min: %.1f\n", val);
-                        }
-                        else
-                        {
-                            printf("[ERRO] temp_min (%.1f) >= temp_max (%.1f)\n", val, config.temp_max);
-                            snprintf(field_name, sizeof(field_name), "%s >= temp_max (%.1f)", key, config.temp_max);
-                        }
-                    }
+                    cfg.temp_min = val;
+                    valid = true;
+                    printf("[CONFIG] Novo temp_min: %s\n", val_txt);
                 }
-                else if (strcmp(key, "temp_max") == 0)
+                else
                 {
-                    if (val >= -50.0f && val <= 50.0f)
-                    {
-                        if (val > config.temp_min)
-                        {
-                            config.temp_max = val;
-                            valid = true;
-                            printf("[CONFIG] Novo temp_max: %.1f\n", val);
-                        }
-                        else
-                        {
-                            printf("[ERRO] temp_max (%.1f) <= temp_min (%.1f)\n", val, config.temp_min);
-                            snprintf(field_name, sizeof(field_name), "%s <= temp_min (%.1f)", key, config.temp_min);
-                        }
-                    }
+                    ponto_fixo_formatar(limite_txt, cfg.temp_max);
+                    printf("[ERRO] temp_min (%s) >= temp_max (%s)\n", val_txt, limite_txt);
+                    snprintf(field_name, sizeof(field_name), "%s >= temp_max (%s)", key, limite_txt);
                 }
-                else if (strcmp(key, "hum_min") == 0)
+            }
+        }
+        else if (strcmp(key, "temp_max") == 0)
+        {
+            if (val >= -5000 && val <= 5000)
+            {
+                if (val > cfg.temp_min)
                 {
-                    if (val >= 0.0f && val <= 100.0f)
-                    {
-                        if (val < config.hum_max)
-                        {
-                            config.hum_min = val;
-                            valid = true;
-                            printf("[CONFIG] Novo hum_min: %.1f\n", val);
-                        }
-                        else
-                        {
-                            printf("[ERRO] hum_min (%.1f) >= hum_max (%.1f)\n", val, config.hum_max);
-                            snprintf(field_name, sizeof(field_name), "%s >= hum_max (%.1f)", key, config.hum_max);
-                        }
-                    }
+                    cfg.temp_max = val;
+                    valid = true;
+                    printf("[CONFIG] Novo temp_max: %s\n", val_txt);
                 }
-                else if (strcmp(key, "hum_max") == 0)
+                else
                 {
-                    if (val >= 0.0f && val <= 100.0f)
-                    {
-                        if (val > config.hum_min)
-                        {
-                            config.hum_max = val;
-                            valid = true;
-                            printf("[CONFIG] Novo hum_max: %.1f\n", val);
-                        }
-                        else
-                        {
-                            printf("[ERRO] hum_max (%.1f) <= hum_min (%.1f)\n", val, config.hum_min);
-                            snprintf(field_name, sizeof(field_name), "%s <= hum_min (%.1f)", key, config.hum_min);
-                        }
-                    }
+                    ponto_fixo_formatar(limite_txt, cfg.temp_min);
+                    printf("[ERRO] temp_max (%s) <= temp_min (%s)\n", val_txt, limite_txt);
+                    snprintf(field_name, sizeof(field_name), "%s <= temp_min (%s)", key, limite_txt);
                 }
-                else if (strcmp(key, "press_min") == 0)
+            }
+        }
+        else if (strcmp(key, "hum_min") == 0)
+        {
+            if (val >= 0 && val <= 10000)
+            {
+                if (val < cfg.hum_max)
                 {
-                    if (val >= 300.0f && val <= 1100.0f)
-                    {
-                        if (val < config.press_max)
-                        {
-                            config.press_min = val;
-                            valid = true;
-                            printf("[CONFIG] Novo press_min: %.1f\n", val);
-                        }
-                        else
-                        {
-                            printf("[ERRO] press_min (%.1f) >= press_max (%.1f)\n", val, config.press_max);
-                            snprintf(field_name, sizeof(field_name), "%s >= press_max (%.1f)", key, config.press_max);
-                        }
-                    }
+                    cfg.hum_min = val;
+                    valid = true;
+                    printf("[CONFIG] Novo hum_min: %s\n", val_txt);
                 }
-                else if (strcmp(key, "press_max") == 0)
+                else
                 {
-                    if (val >= 300.0f && val <= 1100.0f)
-                    {
-                        if (val > config.press_min)
-                        {
-                            config.press_max = val;
-                            valid = true;
-                            printf("[CONFIG] Novo press_max: %.1f\n", val);
-                        }
-                        else
-                        {
-                            printf("[ERRO] press_max (%.1f) <= press_min (%.1f)\n", val, config.press_min);
-                            snprintf(field_name, sizeof(field_name), "%s <= press_min (%.1f)", key, config.press_min);
-                        }
-                    }
+                    ponto_fixo_formatar(limite_txt, cfg.hum_max);
+                    printf("[ERRO] hum_min (%s) >= hum_max (%s)\n", val_txt, limite_txt);
+                    snprintf(field_name, sizeof(field_name), "%s >= hum_max (%s)", key, limite_txt);
                 }
-                else if (strcmp(key, "temp_offset") == 0)
+            }
+        }
+        else if (strcmp(key, "hum_max") == 0)
+        {
+            if (val >= 0 && val <= 10000)
+            {
+                if (val > cfg.hum_min)
                 {
-                    if (val >= -10.0f && val <= 10.0f)
-                    {
-                        config.temp_offset = val;
-                        valid = true;
-                        printf("[CONFIG] Novo temp_offset: %.1f\n", val);
-                    }
+                    cfg.hum_max = val;
+                    valid = true;
+                    printf("[CONFIG] Novo hum_max: %s\n", val_txt);
                 }
-                else if (strcmp(key, "hum_offset") == 0)
+                else
                 {
-                    if (val >= -10.0f && val <= 10.0f)
-                    {
-                        config.hum_offset = val;
-                        valid = true;
-                        printf("[CONFIG] Novo hum_offset: %.1f\n", val);
-                    }
+                    ponto_fixo_formatar(limite_txt, cfg.hum_min);
+                    printf("[ERRO] hum_max (%s) <= hum_min (%s)\n", val_txt, limite_txt);
+                    snprintf(field_name, sizeof(field_name), "%s <= hum_min (%s)", key, limite_txt);
                 }
-                else if (strcmp(key, "press_offset") == 0)
+            }
+        }
+        else if (strcmp(key, "press_min") == 0)
+        {
+            if (val >= 30000 && val <= 110000)
+            {
+                if (val < cfg.press_max)
                 {
-                    if (val >= -50.0f && val <= 50.0f)
-                    {
-                        config.press_offset = val;
-                        valid = true;
-                        printf("[CONFIG] Novo press_offset: %.1f\n", val);
-                    }
+                    cfg.press_min = val;
+                    valid = true;
+                    printf("[CONFIG] Novo press_min: %s\n", val_txt);
                 }
                 else
                 {
-                    printf("[ERRO] Parâmetro desconhecido: %s\n", key);
-                    snprintf(field_name, sizeof(field_name), "%s (desconhecido)", key);
+                    ponto_fixo_formatar(limite_txt, cfg.press_max);
+                    printf("[ERRO] press_min (%s) >= press_max (%s)\n", val_txt, limite_txt);
+                    snprintf(field_name, sizeof(field_name), "%s >= press_max (%s)", key, limite_txt);
                 }
-
-                if (!valid)
+            }
+        }
+        else if (strcmp(key, "press_max") == 0)
+        {
+            if (val >= 30000 && val <= 110000)
+            {
+                if (val > cfg.press_min)
                 {
-                    char err_buf[64];
-                    snprintf(err_buf, sizeof(err_buf), "{\"field\":\"%s\",\"error\":\"Valor fora do intervalo: %.1f\"}", field_name, val);
-                    if (!first_error) strncat(errors, ",", sizeof(errors) - strlen(errors) - 1);
-                    strncat(errors, err_buf, sizeof(errors) - strlen(errors) - 1);
-                    first_error = false;
+                    cfg.press_max = val;
+                    valid = true;
+                    printf("[CONFIG] Novo press_max: %s\n", val_txt);
                 }
                 else
                 {
-                    updated = true;
-                    char upd_buf[64];
-                    snprintf(upd_buf, sizeof(upd_buf), "{\"field\":\"%s\",\"value\":%.1f}", key, val);
-                    if (!first_update) strncat(updates, ",", sizeof(updates) - strlen(updates) - 1);
-                    strncat(updates, upd_buf, sizeof(updates) - strlen(updates) - 1);
-                    first_update = false;
+                    ponto_fixo_formatar(limite_txt, cfg.press_min);
+                    printf("[ERRO] press_max (%s) <= press_min (%s)\n", val_txt, limite_txt);
+                    snprintf(field_name, sizeof(field_name), "%s <= press_min (%s)", key, limite_txt);
                 }
-
-                pair = strtok(NULL, "&");
             }
-
-            strncat(updates, "]", sizeof(updates) - strlen(updates) - 1);
-            strncat(errors, "]", sizeof(errors) - strlen(errors) - 1);
-            snprintf(response, sizeof(response), "{\"status\":\"%s\",\"message\":\"%s\",\"updates\":%s,\"errors\":%s}",
-                     updated ? "success" : "error",
-                     updated ? "Configuração salva" : "Nenhum parâmetro válido aplicado",
-                     updates, errors);
-
-            if (updated)
+        }
+        else if (strcmp(key, "temp_offset") == 0)
+        {
+            if (val >= -1000 && val <= 1000)
             {
-                printf("[CONFIG] Configurações aplicadas: Tmin=%.1f, Tmax=%.1f, Hmin=%.1f, Hmax=%.1f, Pmin=%.1f, Pmax=%.1f, Toff=%.1f, Hoff=%.1f, Poff=%.1f\n",
-                       config.temp_min, config.temp_max, config.hum_min, config.hum_max,
-                       config.press_min, config.press_max, config.temp_offset, config.hum_offset, config.press_offset);
+                cfg.temp_offset = val;
+                valid = true;
+                printf("[CONFIG] Novo temp_offset: %s\n", val_txt);
             }
-            else
+        }
+        else if (strcmp(key, "hum_offset") == 0)
+        {
+            if (val >= -1000 && val <= 1000)
+            {
+                cfg.hum_offset = val;
+                valid = true;
+                printf("[CONFIG] Novo hum_offset: %s\n", val_txt);
+            }
+        }
+        else if (strcmp(key, "press_offset") == 0)
+        {
+            if (val >= -5000 && val <= 5000)
+            {
+                cfg.press_offset = val;
+                valid = true;
+                printf("[CONFIG] Novo press_offset: %s\n", val_txt);
+            }
+        }
+        else if (strcmp(key, "bmp280_perfil") == 0)
+        {
+            if (val >= 0 && val < BMP280_PROFILE_COUNT * PONTO_FIXO_ESCALA && val % PONTO_FIXO_ESCALA == 0)
             {
-                printf("[CONFIG] Nenhuma configuração aplicada.\n");
+                cfg.bmp280_perfil = (uint8_t)(val / PONTO_FIXO_ESCALA);
+                valid = true;
+                printf("[CONFIG] Novo bmp280_perfil: %s\n", bmp280_profile_name((bmp280_profile_t)cfg.bmp280_perfil));
             }
+        }
+        else
+        {
+            printf("[ERRO] Parâmetro desconhecido: %s\n", key);
+            snprintf(field_name, sizeof(field_name), "%s (desconhecido)", key);
+        }
 
-            xSemaphoreGive(mutex_config);
+        if (!valid)
+        {
+            char err_buf[96]; // Nome com o motivo (até 31) e valor (até 12) sem truncar o JSON
+            snprintf(err_buf, sizeof(err_buf), "{\"field\":\"%s\",\"error\":\"Valor fora do intervalo: %s\"}", field_name, val_txt);
+            if (!first_error) strncat(errors, ",", sizeof(errors) - strlen(errors) - 1);
+            strncat(errors, err_buf, sizeof(errors) - strlen(errors) - 1);
+            first_error = false;
         }
         else
         {
-            snprintf(response, sizeof(response), "{\"status\":\"error\",\"message\":\"Erro ao acessar configuração\",\"updates\":[],\"errors\":[]}");
-            printf("[ERRO] Falha ao obter mutex_config\n");
+            updated = true;
+            char upd_buf[64];
+            snprintf(upd_buf, sizeof(upd_buf), "{\"field\":\"%s\",\"value\":%s}", key, val_txt);
+            if (!first_update) strncat(updates, ",", sizeof(updates) - strlen(updates) - 1);
+            strncat(updates, upd_buf, sizeof(updates) - strlen(updates) - 1);
+            first_update = false;
         }
 
-        free(body_copy);
+        pair = strtok_r(NULL, "&", &salvo_pares);
+    }
 
-        char header[256];
-        snprintf(header, sizeof(header), "HTTP/1.1 %s\r\nContent-Type: application/json\r\n%sContent-Length: %zu\r\nConnection: close\r\n\r\n",
-                 updated ? "200 OK" : "400 Bad Request", cors_headers, strlen(response));
-        send_http_response(tpcb, header, response, state);
+    strncat(updates, "]", sizeof(updates) - strlen(updates) - 1);
+    strncat(errors, "]", sizeof(errors) - strlen(errors) - 1);
+    snprintf(resposta, resposta_len, "{\"status\":\"%s\",\"message\":\"%s\",\"updates\":%s,\"errors\":%s}",
+             updated ? "success" : "error",
+             updated ? "Configuração salva" : "Nenhum parâmetro válido aplicado",
+             updates, errors);
+
+    if (updated)
+    {
+        char resumo[256];
+        config_gravar_isr(&cfg);
+        montar_json_config(resumo, sizeof(resumo), &cfg);
+        printf("[CONFIG] Configurações aplicadas: %s\n", resumo);
+        pubsub_publicar(PUBSUB_CONFIG);
     }
-    else if (strstr(req, "GET /") != NULL || strstr(req, "GET /index.html") != NULL)
+    else
+    {
+        printf("[CONFIG] Nenhuma configuração aplicada.\n");
+    }
+
+    return updated;
+}
+
+static void rota_cfg(struct tcp_pcb *tpcb, const http_parser_t *req, conn_state_t *state)
+{
+    if (req->corpo_len == 0)
+    {
+        printf("[ERRO] Corpo da requisição POST não encontrado\n");
+        const char *erro = "{\"status\":\"error\",\"message\":\"Corpo ausente\"}";
+        char *header = rascunho_reservar(state, HTTP_CABECALHO_MAX);
+        montar_cabecalho(header, HTTP_CABECALHO_MAX, "400 Bad Request", "application/json", NULL, strlen(erro), state);
+        send_http_response(tpcb, header, erro, state);
+        return;
+    }
+
+    // Cópia no rascunho: strtok_r altera o texto e o corpo pertence ao parser
+    char *body_copy = rascunho_reservar(state, req->corpo_len + 1);
+    memcpy(body_copy, req->corpo, req->corpo_len + 1);
+
+    char *response = rascunho_reservar(state, CFG_RESPOSTA_MAX);
+    bool updated = aplicar_configuracao(body_copy, response, CFG_RESPOSTA_MAX);
+
+    char *header = rascunho_reservar(state, HTTP_CABECALHO_MAX);
+    montar_cabecalho(header, HTTP_CABECALHO_MAX, updated ? "200 OK" : "400 Bad Request", "application/json", NULL, strlen(response), state);
+    send_http_response(tpcb, header, response, state);
+}
+
+static void rota_index(struct tcp_pcb *tpcb, const http_parser_t *req, conn_state_t *state)
+{
+    char *header = rascunho_reservar(state, HTTP_CABECALHO_MAX);
+    if (req->aceita_gzip)
     {
-        char header[256];
-        snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\n%sContent-Length: %zu\r\nConnection: close\r\n\r\n", cors_headers, strlen(html_page));
-        send_http_response(tpcb, header, html_page, state);
+        montar_cabecalho(header, HTTP_CABECALHO_MAX, "200 OK", "text/html", "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n", sizeof(html_page_gz), state);
+        send_http_response_static(tpcb, header, (const char *)html_page_gz, sizeof(html_page_gz), state);
     }
     else
     {
-        char header[256];
-        snprintf(header, sizeof(header), "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n%sContent-Length: 12\r\nConnection: close\r\n\r\n", cors_headers);
-        send_http_response(tpcb, header, "404 Not Found", state);
+#if HTML_PAGE_HAS_IDENTITY
+        montar_cabecalho(header, HTTP_CABECALHO_MAX, "200 OK", "text/html", "Vary: Accept-Encoding\r\n", sizeof(html_page) - 1, state);
+        send_http_response_static(tpcb, header, html_page, sizeof(html_page) - 1, state);
+#else
+        montar_cabecalho(header, HTTP_CABECALHO_MAX, "406 Not Acceptable", "text/plain", NULL, 14, state);
+        send_http_response(tpcb, header, "Requer gzip.\r\n", state);
+#endif
     }
 }
 
-static err_t webserver_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
+// Gera {"agora":..,"intervalo":..,"amostras":[[t,temp,umid,press],...]} a partir do cursor
+static size_t gerar_historico(conn_state_t *state, char *buf, size_t max, bool *fim)
 {
-    conn_state_t *state = (conn_state_t *)arg;
+    size_t n = 0;
+    if (state->hist_fase == 0)
+    {
+        n = snprintf(buf, max, "{\"agora\":%lu,\"intervalo\":%d,\"amostras\":[",
+                     (unsigned long)to_ms_since_boot(get_absolute_time()), HISTORICO_INTERVALO_MS);
+        state->hist_fase = 1;
+    }
 
-    if (!p)
+    while (state->hist_cursor < state->hist_fim)
     {
-        printf("[WEBSERVER] Conexão fechada pelo cliente %s\n", ipaddr_ntoa(&tpcb->remote_ip));
-        close_connection(state);
-        return ERR_OK;
+        amostra_historico_t a;
+        if (!historico_ler(state->hist_cursor, &a))
+        {
+            // Sobrescrita durante um envio lento: pula para a mais antiga disponível
+            state->hist_cursor = historico_mais_antiga();
+            continue;
+        }
+        sensor_texto_t valores;
+        sensor_formatar(&a.dados, &valores);
+        char linha[64];
+        int len = snprintf(linha, sizeof(linha), "%s[%lu,%s,%s,%s]", state->hist_enviadas ? "," : "",
+                           (unsigned long)a.t_ms, valores.temp, valores.hum, valores.press);
+        if (n + len > max)
+            return n;
+        memcpy(buf + n, linha, len);
+        n += len;
+        state->hist_cursor++;
+        state->hist_enviadas++;
     }
 
-    if (p->tot_len > MAX_REQUEST_SIZE)
+    if (n + 2 > max)
+        return n;
+    memcpy(buf + n, "]}", 2);
+    state->hist_fase = 2;
+    *fim = true;
+    return n + 2;
+}
+
+// GET /history?since=<t>&max=<n>: amostras com t > since (ms desde o boot), no máximo as n mais recentes
+static void rota_history(struct tcp_pcb *tpcb, const http_parser_t *req, conn_state_t *state)
+{
+    char valor[12];
+    uint32_t since = 0, max = HISTORICO_CAPACIDADE;
+    if (http_query_valor(req->query, "since", valor, sizeof(valor)))
+        since = strtoul(valor, NULL, 10);
+    if (http_query_valor(req->query, "max", valor, sizeof(valor)))
+        max = strtoul(valor, NULL, 10);
+
+    state->hist_fim = __atomic_load_n(&historico_total, __ATOMIC_ACQUIRE);
+    state->hist_cursor = historico_buscar(since, state->hist_fim);
+    if (state->hist_fim - state->hist_cursor > max)
+        state->hist_cursor = state->hist_fim - max;
+    state->hist_enviadas = 0;
+    state->hist_fase = 0;
+    state->chunked = !req->http10;
+    if (!state->chunked)
+        state->keep_alive = false;
+
+    char *header = rascunho_reservar(state, HTTP_CABECALHO_MAX);
+    montar_cabecalho(header, HTTP_CABECALHO_MAX, "200 OK", "application/json", "Cache-Control: no-store\r\n", HTTP_TAMANHO_INDEFINIDO, state);
+    send_http_response_gerada(tpcb, header, gerar_historico, state);
+}
+
+// Conexões de stream (SSE e WebSocket) ocupam um PCB indefinidamente: acima do limite,
+// responde 503 para o cliente tentar de novo mais tarde
+static bool aceitar_assinante(struct tcp_pcb *tpcb, conn_state_t *state)
+{
+    int assinantes = 0;
+    for (int i = 0; i < MAX_CONNECTIONS; i++)
     {
-        printf("[ERRO] Requisição muito grande de %s: %d bytes\n", ipaddr_ntoa(&tpcb->remote_ip), p->tot_len);
-        send_http_response(tpcb, "HTTP/1.1 413 Payload Too Large\r\nContent-Type: text/plain\r\nConnection: close\r\nContent-Length: 16\r\n\r\nPayload Too Large", NULL, state);
-        pbuf_free(p);
-        return ERR_OK;
+        if (conexoes[i].pcb && (conexoes[i].sse || conexoes[i].ws))
+            assinantes++;
+    }
+    if (assinantes < STREAM_MAX_ASSINANTES)
+        return true;
+
+    printf("[WEBSERVER] Limite de assinantes atingido, recusando %s\n", ipaddr_ntoa(&tpcb->remote_ip));
+    const char *texto = "503 Service Unavailable";
+    char *header = rascunho_reservar(state, HTTP_CABECALHO_MAX);
+    montar_cabecalho(header, HTTP_CABECALHO_MAX, texto, "text/plain", "Retry-After: 10\r\n", strlen(texto), state);
+    send_http_response(tpcb, header, texto, state);
+    return false;
+}
+
+// Emite a leitura mais recente como evento, se ainda não enviada a este assinante
+static size_t gerar_eventos(conn_state_t *state, char *buf, size_t max, bool *fim)
+{
+    (void)fim;
+    size_t n = 0;
+    if (!state->sse_iniciado)
+    {
+        n = snprintf(buf, max, "retry: %d\n\n", SSE_RETRY_MS);
+        state->sse_iniciado = true;
     }
 
+    if (leitura_seq() == state->sse_seq)
+        return n;
+    leitura_t leitura;
+    leitura_obter(&leitura);
+
+    char campos[192];
+    montar_campos_leitura(campos, sizeof(campos), &leitura);
+    char evento[224];
+    int len = snprintf(evento, sizeof(evento), "id: %lu\ndata: {%s}\n\n", (unsigned long)leitura.seq, campos);
+    if (n + len > max)
+        return n;
+    memcpy(buf + n, evento, len);
+    state->sse_seq = leitura.seq;
     state->timeout = make_timeout_time_ms(TCP_TIMEOUT_MS);
+    return n + len;
+}
+
+// GET /events: text/event-stream mantido aberto; cada nova leitura é empurrada por eventos_notificar
+static void rota_events(struct tcp_pcb *tpcb, const http_parser_t *req, conn_state_t *state)
+{
+    (void)req;
+    if (!aceitar_assinante(tpcb, state))
+        return;
+
+    // Sem Content-Length nem chunked: o corpo vai até o fechamento da conexão
+    state->sse = true;
+    state->sse_iniciado = false;
+    state->sse_seq = leitura_seq() - 1;
+    state->chunked = false;
+    state->keep_alive = false;
+
+    char *header = rascunho_reservar(state, HTTP_CABECALHO_MAX);
+    montar_cabecalho(header, HTTP_CABECALHO_MAX, "200 OK", "text/event-stream", "Cache-Control: no-store\r\n", HTTP_TAMANHO_INDEFINIDO, state);
+    send_http_response_gerada(tpcb, header, gerar_eventos, state);
+    printf("[WEBSERVER] Assinante de eventos conectado: %s\n", ipaddr_ntoa(&tpcb->remote_ip));
+}
+
+// Chamada por tarefa_webserver a cada leitura publicada: o envio pelo lwIP fica no
+// núcleo da rede
+static void eventos_notificar(void)
+{
+    cyw43_arch_lwip_begin();
+    for (int i = 0; i < MAX_CONNECTIONS; i++)
+    {
+        conn_state_t *c = &conexoes[i];
+        if (!c->pcb || !(c->sse || c->ws) || !c->gerador)
+            continue;
+        err_t err = enviar_corpo_gerado(c->pcb, c);
+        if (err == ERR_OK)
+            err = tcp_output(c->pcb);
+        if (err != ERR_OK)
+        {
+            printf("[ERRO] Falha ao enviar evento para %s: %d\n", ipaddr_ntoa(&c->pcb->remote_ip), err);
+            close_connection(c);
+        }
+    }
+    cyw43_arch_lwip_end();
+}
+
+// ===================== WEBSOCKET =====================
+// Enfileira um frame do servidor na fila da conexão; gerar_ws a esvazia conforme o
+// lwIP libera espaço. A fila limitada é a única memória que um cliente lento retém.
+static bool ws_enfileirar(conn_state_t *state, ws_opcode_t opcode, const void *dados, size_t len)
+{
+    uint8_t cabecalho[WS_MAX_CABECALHO];
+    size_t cab_len = ws_montar_cabecalho(cabecalho, opcode, len);
+    if (state->ws_fila_len + cab_len + len > sizeof(state->ws_fila))
+    {
+        printf("[ERRO] Fila do WebSocket cheia, descartando frame de %zu bytes\n", len);
+        return false;
+    }
+    memcpy(state->ws_fila + state->ws_fila_len, cabecalho, cab_len);
+    memcpy(state->ws_fila + state->ws_fila_len + cab_len, dados, len);
+    state->ws_fila_len += (uint16_t)(cab_len + len);
+    return true;
+}
+
+// Inicia o fechamento: nenhum frame é lido depois deste e a conexão fecha após entregá-lo
+static void ws_fechar(conn_state_t *state, uint16_t codigo)
+{
+    uint8_t payload[2] = {(uint8_t)(codigo >> 8), (uint8_t)codigo};
+    ws_enfileirar(state, WS_OP_FECHAR, payload, sizeof(payload));
+    state->ws_fechando = true;
+}
+
+// Esvazia a fila de respostas e depois envia a leitura mais recente, se ainda não enviada.
+// Leituras não passam pela fila: um cliente lento recebe só a última, nunca um acúmulo.
+static size_t gerar_ws(conn_state_t *state, char *buf, size_t max, bool *fim)
+{
+    size_t n = state->ws_fila_len < max ? state->ws_fila_len : max;
+    if (n > 0)
+    {
+        memcpy(buf, state->ws_fila, n);
+        memmove(state->ws_fila, state->ws_fila + n, state->ws_fila_len - n);
+        state->ws_fila_len -= (uint16_t)n;
+        if (state->ws_fila_len > 0)
+            return n;
+    }
+    if (state->ws_fechando)
+    {
+        *fim = true;
+        return n;
+    }
+
+    if (leitura_seq() == state->sse_seq)
+        return n;
+    leitura_t leitura;
+    leitura_obter(&leitura);
+
+    char campos[192];
+    montar_campos_leitura(campos, sizeof(campos), &leitura);
+    char texto[224];
+    int len = snprintf(texto, sizeof(texto), "{\"tipo\":\"leitura\",%s}", campos);
+    if (n + WS_MAX_CABECALHO + len > max)
+        return n;
+    n += ws_montar_cabecalho((uint8_t *)buf + n, WS_OP_TEXTO, len);
+    memcpy(buf + n, texto, len);
+    state->sse_seq = leitura.seq;
+    state->timeout = make_timeout_time_ms(TCP_TIMEOUT_MS);
+    return n + len;
+}
+
+// Mensagens de texto do dashboard: "config" pede a configuração atual; qualquer outra é
+// tratada como o formulário de /cfg (chave=valor&...) e respondida com o resultado
+// seguido da configuração resultante.
+static void ws_tratar_mensagem(struct tcp_pcb *tpcb, conn_state_t *state)
+{
+    size_t len;
+    uint8_t *dados = ws_parser_dados(&state->ws_parser, &len);
+    char *json = rascunho_reservar(state, CFG_RESPOSTA_MAX);
+
+    switch (state->ws_parser.concluido)
+    {
+    case WS_OP_TEXTO:
+        if (strcmp((char *)dados, "config") != 0)
+        {
+            printf("[WEBSERVER] Configuração recebida via WebSocket de %s\n", ipaddr_ntoa(&tpcb->remote_ip));
+            memcpy(json, "{\"tipo\":\"cfg\",", 14);
+            aplicar_configuracao((char *)dados, json + 13, CFG_RESPOSTA_MAX - 13);
+            json[13] = ',';
+            ws_enfileirar(state, WS_OP_TEXTO, json, strlen(json));
+        }
+        memcpy(json, "{\"tipo\":\"config\",", 17);
+        config_limits_t cfg;
+        config_ler_isr(&cfg);
+        montar_json_config(json + 16, CFG_RESPOSTA_MAX - 16, &cfg);
+        json[16] = ',';
+        ws_enfileirar(state, WS_OP_TEXTO, json, strlen(json));
+        break;
+    case WS_OP_BINARIO:
+        ws_fechar(state, WS_FECHAMENTO_NAO_SUPORTADO);
+        break;
+    case WS_OP_PING:
+        ws_enfileirar(state, WS_OP_PONG, dados, len);
+        break;
+    case WS_OP_FECHAR:
+        // Ecoa o código recebido, como pede o RFC
+        printf("[WEBSERVER] WebSocket fechado pelo cliente %s\n", ipaddr_ntoa(&tpcb->remote_ip));
+        ws_fechar(state, len >= 2 ? (uint16_t)(dados[0] << 8 | dados[1]) : WS_FECHAMENTO_NORMAL);
+        break;
+    default:
+        break; // PONG: só confirma que o cliente está vivo
+    }
+}
+
+// Lê os frames pendentes enquanto houver espaço na fila para as respostas. Sem espaço, os
+// bytes ficam sem tcp_recved e a janela TCP do cliente freia o envio até os ACKs esvaziarem a fila.
+static void processar_frames_ws(struct tcp_pcb *tpcb, conn_state_t *state)
+{
+    while (state->pcb && state->pendente && !state->ws_fechando &&
+           sizeof(state->ws_fila) - state->ws_fila_len >= WS_RESPOSTA_MAX)
+    {
+        size_t consumidos;
+        ws_parser_resultado_t res = ws_parser_consumir(&state->ws_parser, (const uint8_t *)state->pendente->payload,
+                                                       state->pendente->len, &consumidos);
+        if (consumidos > 0)
+        {
+            tcp_recved(tpcb, (u16_t)consumidos);
+            state->pendente = pbuf_free_header(state->pendente, (u16_t)consumidos);
+        }
+
+        if (res == WS_PARSER_COMPLETO)
+        {
+            state->rascunho_usado = 0;
+            ws_tratar_mensagem(tpcb, state);
+        }
+        else if (res == WS_PARSER_ERRO)
+        {
+            printf("[ERRO] Frame WebSocket inválido de %s: fechando com %u\n", ipaddr_ntoa(&tpcb->remote_ip), state->ws_parser.codigo_erro);
+            ws_fechar(state, state->ws_parser.codigo_erro);
+        }
+    }
+
+    if (state->pcb && state->ws_fechando && state->pendente)
+    {
+        tcp_recved(tpcb, state->pendente->tot_len);
+        pbuf_free(state->pendente);
+        state->pendente = NULL;
+    }
+
+    if (state->pcb && state->gerador && state->ws_fila_len > 0)
+    {
+        err_t err = enviar_corpo_gerado(tpcb, state);
+        if (err == ERR_OK)
+            err = tcp_output(tpcb);
+        if (err != ERR_OK)
+        {
+            printf("[ERRO] Falha ao enviar frame WebSocket: %d\n", err);
+            close_connection(state);
+        }
+    }
+}
+
+// GET /ws: handshake do RFC 6455. Depois do 101 a conexão deixa de ser HTTP e recebe a
+// mesma notificação de leituras dos assinantes de /events.
+static void rota_ws(struct tcp_pcb *tpcb, const http_parser_t *req, conn_state_t *state)
+{
+    if (!req->upgrade_websocket || !req->conexao_upgrade || req->websocket_chave[0] == '\0' || req->http10)
+    {
+        responder_texto(tpcb, state, 400, NULL);
+        return;
+    }
+    if (req->websocket_versao != 13)
+    {
+        responder_texto(tpcb, state, 426, "Sec-WebSocket-Version: 13\r\n");
+        return;
+    }
+    if (!aceitar_assinante(tpcb, state))
+        return;
+
+    char accept[WS_TAMANHO_ACCEPT + 1];
+    ws_calcular_accept(req->websocket_chave, accept);
+
+    state->ws = true;
+    state->ws_fechando = false;
+    state->ws_fila_len = 0;
+    state->sse_seq = leitura_seq() - 1;
+    state->chunked = false;
+    state->keep_alive = false;
+
+    char *header = rascunho_reservar(state, HTTP_CABECALHO_MAX);
+    snprintf(header, HTTP_CABECALHO_MAX, "HTTP/1.1 %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n",
+             http_status_texto(101), accept);
+    send_http_response_gerada(tpcb, header, gerar_ws, state);
+    printf("[WEBSERVER] WebSocket aberto com %s\n", ipaddr_ntoa(&tpcb->remote_ip));
+}
+
+typedef void (*rota_handler_t)(struct tcp_pcb *tpcb, const http_parser_t *req, conn_state_t *state);
+
+typedef struct
+{
+    http_metodo_t metodo;
+    const char *caminho;
+    rota_handler_t handler;
+} rota_t;
+
+static const rota_t rotas[] = {
+    {HTTP_METODO_GET, "/", rota_index},
+    {HTTP_METODO_GET, "/index.html", rota_index},
+    {HTTP_METODO_GET, "/json", rota_json},
+    {HTTP_METODO_GET, "/bin", rota_bin},
+    {HTTP_METODO_GET, "/config", rota_config},
+    {HTTP_METODO_GET, "/history", rota_history},
+    {HTTP_METODO_GET, "/stats", rota_stats},
+    {HTTP_METODO_GET, "/events", rota_events},
+    {HTTP_METODO_GET, "/ws", rota_ws},
+    {HTTP_METODO_POST, "/cfg", rota_cfg},
+};
+
+// Procura o caminho exato na tabela de rotas; caminho conhecido com outro método gera 405
+static void handle_http_request(struct tcp_pcb *tpcb, const http_parser_t *req, conn_state_t *state)
+{
+    printf("[WEBSERVER] Processando requisição de %s: %s %s\n", ipaddr_ntoa(&tpcb->remote_ip), req->metodo_txt, req->caminho);
+
+    bool caminho_conhecido = false;
+    for (size_t i = 0; i < sizeof(rotas) / sizeof(rotas[0]); i++)
+    {
+        if (strcmp(rotas[i].caminho, req->caminho) != 0)
+            continue;
+        if (rotas[i].metodo == req->metodo)
+        {
+            rotas[i].handler(tpcb, req, state);
+            return;
+        }
+        caminho_conhecido = true;
+    }
+
+    if (req->metodo == HTTP_METODO_DESCONHECIDO)
+        responder_texto(tpcb, state, 501, NULL);
+    else if (caminho_conhecido)
+        responder_texto(tpcb, state, 405, "Allow: GET, POST\r\n");
+    else
+        responder_texto(tpcb, state, 404, NULL);
+}
 
-    char *req = (char *)calloc(1, p->tot_len + 1);
-    if (!req)
+// Alimenta o parser com os pbufs recebidos, sem copiá-los, e atende as requisições
+// completas em ordem (pipelining). Só os bytes consumidos são confirmados com
+// tcp_recved, então um cliente que envia mais rápido do que o servidor responde é
+// freado pela janela TCP. Uma resposta com corpo estático ainda em envio, ou pouco
+// espaço no buffer de envio, suspende o laço até webserver_sent retomá-lo.
+static void processar_requisicoes(struct tcp_pcb *tpcb, conn_state_t *state)
+{
+    if (state->ws)
+    {
+        processar_frames_ws(tpcb, state);
+        return;
+    }
+
+    while (state->pcb && state->pendente && state->remaining_len == 0 && !state->gerador)
     {
-        printf("[ERRO] Falha ao alocar memória para requisição de %s\n", ipaddr_ntoa(&tpcb->remote_ip));
-        send_http_response(tpcb, "HTTP/1.1 500 Internal Server Error\r\nContent-Type: text/plain\r\nConnection: close\r\nContent-Length: 22\r\n\r\nInternal Server Error", NULL, state);
-        pbuf_free(p);
+        if (state->bytes_acked < state->bytes_queued && tcp_sndbuf(tpcb) < HTTP_PIPELINE_MIN_SNDBUF)
+            break;
+
+        size_t consumidos;
+        http_parser_resultado_t res = http_parser_consumir(&state->parser, (const char *)state->pendente->payload,
+                                                           state->pendente->len, &consumidos);
+        if (consumidos > 0)
+        {
+            tcp_recved(tpcb, (u16_t)consumidos);
+            state->pendente = pbuf_free_header(state->pendente, (u16_t)consumidos);
+        }
+
+        state->rascunho_usado = 0;
+        if (res == HTTP_PARSER_COMPLETO)
+        {
+            state->keep_alive = http_parser_keep_alive(&state->parser);
+            handle_http_request(tpcb, &state->parser, state);
+            if (state->ws)
+            {
+                // Bytes após o handshake já são frames
+                ws_parser_iniciar(&state->ws_parser);
+                if (state->pcb)
+                    processar_frames_ws(tpcb, state);
+                return;
+            }
+            http_parser_iniciar(&state->parser);
+        }
+        else if (res == HTTP_PARSER_ERRO)
+        {
+            printf("[ERRO] Requisição inválida de %s: %s\n", ipaddr_ntoa(&tpcb->remote_ip), http_status_texto(state->parser.erro));
+            state->keep_alive = false;
+            responder_texto(tpcb, state, state->parser.erro, NULL);
+        }
+
+        if (state->pcb && !state->keep_alive && res != HTTP_PARSER_INCOMPLETO)
+        {
+            // Conexão será fechada após a resposta: descarta requisições seguintes
+            if (state->pendente)
+            {
+                tcp_recved(tpcb, state->pendente->tot_len);
+                pbuf_free(state->pendente);
+                state->pendente = NULL;
+            }
+            break;
+        }
+    }
+}
+
+static err_t webserver_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
+{
+    conn_state_t *state = (conn_state_t *)arg;
+
+    if (!p)
+    {
+        printf("[WEBSERVER] Conexão fechada pelo cliente %s\n", ipaddr_ntoa(&tpcb->remote_ip));
+        if (conexao_ociosa(state))
+        {
+            close_connection(state);
+            return ERR_OK;
+        }
+        if (state->sse || state->ws)
+        {
+            // Streams nunca terminam por conta própria: não há o que concluir
+            close_connection(state);
+            return ERR_OK;
+        }
+        // Meio fechamento: termina as respostas em andamento antes de fechar
+        state->fin_recebido = true;
+        state->keep_alive = false;
         return ERR_OK;
     }
 
-    pbuf_copy_partial(p, req, p->tot_len, 0);
-    req[p->tot_len] = '\0';
-    handle_http_request(tpcb, req, state);
-    free(req);
-    tcp_recved(tpcb, p->tot_len);
-    pbuf_free(p);
+    state->timeout = make_timeout_time_ms(TCP_TIMEOUT_MS);
+    if (state->pendente)
+        pbuf_cat(state->pendente, p);
+    else
+        state->pendente = p;
+
+    state->in_callback = true;
+    processar_requisicoes(tpcb, state);
+    state->in_callback = false;
     return ERR_OK;
 }
 
@@ -1009,7 +2323,7 @@ static err_t webserver_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
     int free_slot = -1;
     for (int i = 0; i < MAX_CONNECTIONS; i++)
     {
-        if (active_connections[i] == NULL)
+        if (vaga_livre(&conexoes[i]))
         {
             free_slot = i;
             break;
@@ -1017,26 +2331,34 @@ static err_t webserver_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
     }
     if (free_slot == -1)
     {
-        printf("[ERRO] Limite de conexões atingido. Rejeitando conexão de %s\n", ipaddr_ntoa(&newpcb->remote_ip));
-        tcp_close(newpcb);
-        return ERR_MEM;
+        // Libera a conexão keep-alive ociosa há mais tempo para atender o novo cliente
+        for (int i = 0; i < MAX_CONNECTIONS; i++)
+        {
+            conn_state_t *c = &conexoes[i];
+            if (c->pcb && conexao_ociosa(c) &&
+                (free_slot == -1 || absolute_time_diff_us(c->timeout, conexoes[free_slot].timeout) > 0))
+                free_slot = i;
+        }
+        if (free_slot != -1)
+        {
+            printf("[WEBSERVER] Fechando conexão ociosa com %s para aceitar nova\n", ipaddr_ntoa(&conexoes[free_slot].remoto));
+            close_connection(&conexoes[free_slot]);
+        }
     }
-
-    conn_state_t *state = (conn_state_t *)calloc(1, sizeof(conn_state_t));
-    if (!state)
+    if (free_slot == -1)
     {
-        printf("[ERRO] Falha ao alocar estado da conexão para %s\n", ipaddr_ntoa(&newpcb->remote_ip));
+        printf("[ERRO] Limite de conexões atingido. Rejeitando conexão de %s\n", ipaddr_ntoa(&newpcb->remote_ip));
         tcp_close(newpcb);
         return ERR_MEM;
     }
 
+    conn_state_t *state = &conexoes[free_slot];
+    // Zera tudo menos o conteúdo do rascunho, que rascunho_usado = 0 já esvazia
+    memset(state, 0, offsetof(conn_state_t, rascunho));
     state->pcb = newpcb;
+    ip_addr_copy(state->remoto, newpcb->remote_ip);
     state->timeout = make_timeout_time_ms(TCP_TIMEOUT_MS);
-    state->response_sent = false;
-    state->remaining_data = NULL;
-    state->remaining_len = 0;
-
-    active_connections[free_slot] = state;
+    http_parser_iniciar(&state->parser);
 
     tcp_arg(newpcb, state);
     tcp_recv(newpcb, webserver_recv);
@@ -1058,6 +2380,7 @@ void tarefa_webserver(void *param)
         if (cyw43_arch_wifi_connect_timeout_ms(WIFI_SSID, WIFI_PASS, CYW43_AUTH_WPA2_AES_PSK, 10000) == 0)
         {
             wifi_connected = true;
+            pubsub_publicar(PUBSUB_REDE);
             break;
         }
         printf("[ERRO] Falha na conexão Wi-Fi, tentativa %d/%d\n", wifi_attempts + 1, max_wifi_attempts);
@@ -1100,12 +2423,14 @@ void tarefa_webserver(void *param)
     printf("[WIFI] Conectado! IP: %s\n", ipaddr_ntoa(&netif_default->ip_addr));
     printf("[SERVIDOR] Servidor web disponível em http://%s:80\n", ipaddr_ntoa(&netif_default->ip_addr));
 
+    int assinante = pubsub_assinar(PUBSUB_BIT(PUBSUB_LEITURA));
     while (1)
     {
         cyw43_arch_poll();
         if (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) != CYW43_LINK_UP)
         {
             wifi_connected = false;
+            pubsub_publicar(PUBSUB_REDE);
             gpio_put(LED_BLUE_PIN, 1);
             printf("[WIFI] Conexão perdida. Tentando reconectar...\n");
             cyw43_arch_wifi_connect_async(WIFI_SSID, WIFI_PASS, CYW43_AUTH_WPA2_AES_PSK);
@@ -1113,48 +2438,73 @@ void tarefa_webserver(void *param)
             if (cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA) == CYW43_LINK_UP)
             {
                 wifi_connected = true;
+                pubsub_publicar(PUBSUB_REDE);
                 gpio_put(LED_BLUE_PIN, 0);
                 printf("[WIFI] Reconectado! IP: %s\n", ipaddr_ntoa(&netif_default->ip_addr));
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(100));
+        // Espera de 100 ms entre as verificações do link, interrompida por uma leitura nova
+        // para os assinantes de /events e /ws
+        if (pubsub_aguardar(assinante, pdMS_TO_TICKS(100)) & PUBSUB_BIT(PUBSUB_LEITURA))
+            eventos_notificar();
     }
 }
 
 // ===================== INTERRUPÇÕES E BOTÕES =====================
+// A interrupção só registra o botão e acorda a tarefa_botoes: printf e a
+// espera antes do BOOTSEL não podem rodar em contexto de interrupção
 void manipulador_interrupcao_gpio(uint gpio, uint32_t eventos)
 {
     static uint32_t ultima = 0;
     uint32_t agora = to_ms_since_boot(get_absolute_time());
-    if (agora - ultima < 200)
+    if (agora - ultima < 200 || !tarefa_botoes_handle)
         return;
     ultima = agora;
-    tratar_botao(gpio);
+
+    UBaseType_t estado = taskENTER_CRITICAL_FROM_ISR();
+    botoes_pendentes |= 1u << gpio;
+    taskEXIT_CRITICAL_FROM_ISR(estado);
+    BaseType_t acordar = pdFALSE;
+    vTaskNotifyGiveFromISR(tarefa_botoes_handle, &acordar);
+    portYIELD_FROM_ISR(acordar);
 }
 
-void tratar_botao(uint btn)
+void tarefa_botoes(void *param)
 {
-    if (btn == BTN_3)
+    while (1)
     {
-        if (xSemaphoreTake(mutex_config, pdMS_TO_TICKS(100)))
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        taskENTER_CRITICAL();
+        uint32_t pendentes = botoes_pendentes;
+        botoes_pendentes = 0;
+        taskEXIT_CRITICAL();
+        for (uint btn = 0; pendentes; btn++, pendentes >>= 1)
         {
-            config.temp_min = TEMP_MIN_DEFAULT;
-            config.temp_max = TEMP_MAX_DEFAULT;
-            config.hum_min = HUM_MIN_DEFAULT;
-            config.hum_max = HUM_MAX_DEFAULT;
-            config.press_min = PRESS_MIN_DEFAULT;
-            config.press_max = PRESS_MAX_DEFAULT;
-            config.temp_offset = 0;
-            config.hum_offset = 0;
-            config.press_offset = 0;
-            xSemaphoreGive(mutex_config);
-            printf("[CONFIG] Limites e offsets resetados para padrão saudável.\n");
+            if (pendentes & 1)
+                tratar_botao(btn);
         }
     }
+}
+
+void tratar_botao(uint btn)
+{
+    if (btn == BTN_3)
+    {
+        const config_limits_t padrao = {
+            .temp_min = TEMP_MIN_DEFAULT, .temp_max = TEMP_MAX_DEFAULT,
+            .hum_min = HUM_MIN_DEFAULT, .hum_max = HUM_MAX_DEFAULT,
+            .press_min = PRESS_MIN_DEFAULT, .press_max = PRESS_MAX_DEFAULT,
+            .temp_offset = 0, .hum_offset = 0, .press_offset = 0,
+            .bmp280_perfil = BMP280_PROFILE_STANDARD
+        };
+        config_gravar(&padrao);
+        pubsub_publicar(PUBSUB_CONFIG);
+        printf("[CONFIG] Limites, offsets e perfil do BMP280 resetados para o padrão.\n");
+    }
     else if (btn == BTN_2)
     {
         printf("[BOOTSEL] Entrando em modo BOOTSEL (USB Mass Storage)...\n");
-        sleep_ms(100);
+        vTaskDelay(pdMS_TO_TICKS(100)); // Tempo para a mensagem sair pela USB
         reset_usb_boot(0, 0);
     }
     else if (btn == BTN_1)